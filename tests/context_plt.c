@@ -0,0 +1,13 @@
+/* Calls a shared library function through the PLT: the first call */
+/* goes through the lazy binding of the dynamic linker, the second */
+/* one through the bound PLT entry. Both calls must be attributed  */
+/* to the context main > vc_plt_scale.                             */
+
+double vc_plt_scale(double x, int n);
+
+int main(void)
+{
+  double x = vc_plt_scale(1.0, 10);
+  x = vc_plt_scale(x, 10);
+  return (x > 0) ? 0 : 1;
+}
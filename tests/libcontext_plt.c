@@ -0,0 +1,11 @@
+/* Shared library of context_plt, its functions are called */
+/* through the PLT                                         */
+
+double vc_plt_scale(double x, int n)
+{
+  int i;
+  for (i = 0; i < n; i++) {
+    x = x * 1.5;
+  }
+  return x;
+}
@@ -33,31 +33,29 @@
 #include "pub_tool_libcassert.h"
 #include "pub_tool_mallocfree.h"
 #include "pub_tool_libcbase.h"
-#include "pub_tool_oset.h"
 
 #include "vc_container.h"
 #include "vc_debuginfo.h"
- 
-#define INIT_SIZE_ARRAY 1024
-#define INDEX_NOT_FOUND -1
-
-static ULong ID_counter = 0;
-
-#define UNINITIALIZED_ID -1
 
 
 void init_FPCounter(FPCounter **T) {
   (*T) = (FPCounter*)VG_(malloc)("fpcounter.init", sizeof(FPCounter));
   (*T)->size = 0;
-  (*T)->capacity = INIT_SIZE_FPCOUNTER;
-  (*T)->data = (FPCounterData)VG_(calloc)("fpcounter.data.init", (*T)->capacity, sizeof(ULong));
+  (*T)->nbPages = 0;
+  (*T)->dirCapacity = INIT_SIZE_FPCOUNTER_DIR;
+  (*T)->pages = (FPCounterPage*)VG_(calloc)("fpcounter.dir.init",
+					    (*T)->dirCapacity,
+					    sizeof(FPCounterPage));
 }
 
 void free_FPCounter(FPCounter **T) {
-  if ((*T)->data) {
-    VG_(free)((*T)->data);
+  ULong i;
+  for (i = 0; i < (*T)->nbPages; i++) {
+    VG_(free)((*T)->pages[i]);
   }
+  VG_(free)((*T)->pages);
   VG_(free)(*T);
+  *T = NULL;
 }
 
 ULong size_FPCounter(const FPCounter *T) {
@@ -65,22 +63,71 @@ ULong size_FPCounter(const FPCounter *T) {
 }
 
 void increment_FPCounter(FPCounter *T) {
+  if (T->size == T->nbPages * FPCOUNTER_PAGE_SIZE) {
+    if (T->nbPages == T->dirCapacity) {
+      T->dirCapacity *= 2;
+      T->pages = (FPCounterPage*)VG_(realloc)("fpcounter.dir.resize", T->pages,
+					      sizeof(FPCounterPage)*T->dirCapacity);
+    }
+    T->pages[T->nbPages] = (FPCounterPage)VG_(calloc)("fpcounter.page",
+						      FPCOUNTER_PAGE_SIZE,
+						      sizeof(ULong));
+    T->nbPages++;
+  }
   T->size++;
-  if (T->size >= T->capacity) {
-    T->capacity *= 2;
-    T->data = (ULong*)VG_(realloc)("fpcounter.resize", T->data, sizeof(ULong)*T->capacity);     
-  }   
 }
 
+ULong* addr_FPCounter(const FPCounter *T, ULong i) {
+  tl_assert(i < T->size);
+  return &(T->pages[i >> FPCOUNTER_PAGE_SHIFT][i & FPCOUNTER_PAGE_MASK]);
+}
+
+ULong get_FPCounter(const FPCounter *T, ULong i) {
+  return *addr_FPCounter(T, i);
+}
+
+void reset_FPCounter(FPCounter *T) {
+  ULong i;
+  for (i = 0; i < T->nbPages; i++) {
+    VG_(memset)(T->pages[i], 0, FPCOUNTER_PAGE_SIZE * sizeof(ULong));
+  }
+}
 
-Word cmpKey_FnContainer(const void* a, const void* b);
-Word cmpKey_FnContainer(const void* a, const void* b) {
-  const ContainerObj* obj_a = (const ContainerObj*)a;
-  const ContainerObj* obj_b = (const ContainerObj*)b;
-  return VG_(strcmp)(obj_a->key, obj_b->key);
+/* Fibonacci hashing of the symbol ID */
+static inline ULong hashKey(const ContainerKey key) {
+  return key * 11400714819323198485ULL;
+}
+
+/* Returns the slot of key, or the empty slot where it would be inserted */
+static inline ULong findSlot(ContainerObj **slots, ULong capacity,
+			     const ContainerKey key) {
+  ULong i = (hashKey(key) >> 32) & (capacity - 1);
+  while (slots[i] && slots[i]->key != key) {
+    i = (i + 1) & (capacity - 1);
+  }
+  return i;
+}
+
+static void FnContainer_Grow(FnContainer *T) {
+  ULong i;
+  const ULong capacity = 2 * T->capacity;
+  ContainerObj **slots = VG_(calloc)("fnctn.resize", capacity,
+				     sizeof(ContainerObj*));
+  for (i = 0; i < T->size; i++) {
+    ContainerObj *obj = T->objs[i];
+    slots[findSlot(slots, capacity, obj->key)] = obj;
+  }
+  VG_(free)(T->slots);
+  T->slots = slots;
+  T->capacity = capacity;
 }
 
 ContainerKey getKey(const DebugInfo *di) {
+  return di->symId;
+}
+
+ContainerObj *ContainerObj_New(FnContainer *T, const ContainerKey *key,
+			       const DebugInfo *di) {
 
   tl_assert(di->dir);
   tl_assert(di->file);
@@ -89,54 +136,64 @@ ContainerKey getKey(const DebugInfo *di) {
   SizeT sizeDir = VG_(strlen)(di->dir);
   SizeT sizeFile = VG_(strlen)(di->file);
   SizeT sizeFun = VG_(strlen)(di->function);
-  SizeT sizeKey = sizeDir + sizeFile + sizeFun + 2;
-  
-  HChar *key = VG_(malloc)("key", sizeof(HChar)*(sizeKey));
-    
-  VG_(sprintf)(key, "%s/%s:%s", di->dir, di->file, di->function);
-
-  return key;
-}
+  SizeT sizeName = sizeDir + sizeFile + sizeFun + 3;
 
-ContainerObj *ContainerObj_New(FnContainer *T, const ContainerKey *key,
-			       const DebugInfo *di) {
-  ContainerObj *newObj = VG_(OSetGen_AllocNode)(T, sizeof(ContainerObj));
-  newObj->key = *key;  
-  VG_(strcpy)(newObj->functionName, di->function);
-  VG_(strcpy)(newObj->libName, di->lib);
-  newObj->ID = ID_counter;
-  ID_counter++;
-  /* VG_(dmsg)("New Obj: %s, %s, %s, %llu\n", *key, di->lib, di->function, ID_counter); */
+  ContainerObj *newObj = VG_(malloc)("fnctn.obj", sizeof(ContainerObj));
+  newObj->key = *key;
+  newObj->name = VG_(malloc)("fnctn.obj.name", sizeof(HChar)*(sizeName));
+  VG_(sprintf)(newObj->name, "%s/%s:%s", di->dir, di->file, di->function);
+  /* Interned strings, valid until the end of the execution */
+  newObj->functionName = di->function;
+  newObj->libName = di->lib;
+  newObj->dirName = di->dir;
+  newObj->fileName = di->file;
+  newObj->line = di->line;
+  newObj->ID = T->size;
   return newObj;
 }
  
 void FnContainer_Init(FnContainer **T) {
-  *T = VG_(OSetGen_Create)(/*keyoff*/0,
-			  cmpKey_FnContainer,
-			  VG_(malloc),
-			  "fnctn.init",
-			  VG_(free));
+  *T = VG_(malloc)("fnctn.init", sizeof(FnContainer));
+  (*T)->capacity = INIT_SIZE_FNCONTAINER;
+  (*T)->slots = VG_(calloc)("fnctn.init.slots", (*T)->capacity,
+			    sizeof(ContainerObj*));
+  (*T)->objsCapacity = INIT_SIZE_FNCONTAINER;
+  (*T)->objs = VG_(malloc)("fnctn.init.objs",
+			   (*T)->objsCapacity * sizeof(ContainerObj*));
+  (*T)->sorted = NULL;
+  (*T)->size = 0;
+  (*T)->iter = 0;
 }
 
 void FnContainer_Free(FnContainer **T) {
-  VG_(OSetGen_Destroy)(*T);
+  ULong i;
+  for (i = 0; i < (*T)->size; i++) {
+    VG_(free)((*T)->objs[i]->name);
+    VG_(free)((*T)->objs[i]);
+  }
+  if ((*T)->sorted) {
+    VG_(free)((*T)->sorted);
+  }
+  VG_(free)((*T)->objs);
+  VG_(free)((*T)->slots);
+  VG_(free)(*T);
+  *T = NULL;
 }
 
-Bool FnContainer_HasObj(const FnContainer *T, const ContainerKey *key) {
-  return VG_(OSetGen_Contains)(T, key);  
+ContainerObj* FnContainer_Lookup(const FnContainer *T, const ContainerKey *key) {
+  return T->slots[findSlot(T->slots, T->capacity, *key)];
 }
 
-inline UInt FnContainer_Size(const FnContainer *T) {
-  return VG_(OSetGen_Size)(T);
+Bool FnContainer_HasObj(const FnContainer *T, const ContainerKey *key) {
+  return FnContainer_Lookup(T, key) != NULL;
 }
 
-ContainerObj *get_FnContainer(const FnContainer *T, const ContainerKey *key);
-inline ContainerObj *get_FnContainer(const FnContainer *T, const ContainerKey *key) {
-  return VG_(OSetGen_Lookup)(T, key);
+inline UInt FnContainer_Size(const FnContainer *T) {
+  return T->size;
 }
 
 ULong FnContainer_ID(const FnContainer *T, const ContainerKey *key) {
-  ContainerObj *obj = get_FnContainer(T, key);
+  ContainerObj *obj = FnContainer_Lookup(T, key);
   if (obj == NULL) {
     VG_(tool_panic)("FnContainer is looking for unknown key");
   } else {
@@ -145,13 +202,145 @@ ULong FnContainer_ID(const FnContainer *T, const ContainerKey *key) {
 }
 
 void FnContainer_Insert(FnContainer *T, ContainerObj *obj) {
-  VG_(OSetGen_Insert)(T, obj);
+  tl_assert(obj->ID == T->size);
+  tl_assert(!FnContainer_HasObj(T, &obj->key));
+
+  /* Keep the load factor under 1/2 */
+  if (2 * (T->size + 1) > T->capacity) {
+    FnContainer_Grow(T);
+  }
+  if (T->size == T->objsCapacity) {
+    T->objsCapacity *= 2;
+    T->objs = VG_(realloc)("fnctn.objs.resize", T->objs,
+			   T->objsCapacity * sizeof(ContainerObj*));
+  }
+
+  T->slots[findSlot(T->slots, T->capacity, obj->key)] = obj;
+  T->objs[T->size] = obj;
+  T->size++;
+}
+
+static Int cmpName_ContainerObj(const void* a, const void* b) {
+  const ContainerObj* obj_a = *(ContainerObj* const*)a;
+  const ContainerObj* obj_b = *(ContainerObj* const*)b;
+  return VG_(strcmp)(obj_a->name, obj_b->name);
 }
 
 void FnContainer_ResetIterator(FnContainer *T) {
-  VG_(OSetGen_ResetIter)(T);
+  if (T->sorted) {
+    VG_(free)(T->sorted);
+  }
+  T->sorted = VG_(malloc)("fnctn.sorted", (T->size + 1) * sizeof(ContainerObj*));
+  VG_(memcpy)(T->sorted, T->objs, T->size * sizeof(ContainerObj*));
+  VG_(ssort)(T->sorted, T->size, sizeof(ContainerObj*), cmpName_ContainerObj);
+  T->iter = 0;
 }
 
 ContainerObj* FnContainer_Next(FnContainer *T) {
-  return VG_(OSetGen_Next)(T);
+  if (T->sorted == NULL || T->iter >= T->size) {
+    return NULL;
+  }
+  return T->sorted[T->iter++];
+}
+
+/* LineContainer */
+
+static inline ULong hashLineKey(const LineKey *key) {
+  ULong h = key->funNo * 11400714819323198485ULL;
+  h = (h ^ (ULong)(Addr)key->file) * 11400714819323198485ULL;
+  h = (h ^ key->line) * 11400714819323198485ULL;
+  h = (h ^ key->addr) * 11400714819323198485ULL;
+  return h >> 32;
+}
+
+static inline Bool sameLineKey(const LineKey *a, const LineKey *b) {
+  return a->funNo == b->funNo && a->file == b->file
+    && a->line == b->line && a->addr == b->addr;
+}
+
+/* Returns the slot of key, or the empty slot where it would be inserted */
+static inline ULong findLineSlot(LineObj **slots, ULong capacity,
+				 const LineKey *key) {
+  ULong i = hashLineKey(key) & (capacity - 1);
+  while (slots[i] && !sameLineKey(&slots[i]->key, key)) {
+    i = (i + 1) & (capacity - 1);
+  }
+  return i;
+}
+
+void LineContainer_Init(LineContainer **T) {
+  *T = VG_(malloc)("linectn.init", sizeof(LineContainer));
+  (*T)->capacity = INIT_SIZE_LINECONTAINER;
+  (*T)->slots = VG_(calloc)("linectn.init.slots", (*T)->capacity,
+			    sizeof(LineObj*));
+  (*T)->dirCapacity = INIT_SIZE_FPCOUNTER_DIR;
+  (*T)->pages = VG_(calloc)("linectn.init.dir", (*T)->dirCapacity,
+			    sizeof(LineObj*));
+  (*T)->nbPages = 0;
+  (*T)->size = 0;
+}
+
+void LineContainer_Free(LineContainer **T) {
+  ULong i;
+  for (i = 0; i < (*T)->nbPages; i++) {
+    VG_(free)((*T)->pages[i]);
+  }
+  VG_(free)((*T)->pages);
+  VG_(free)((*T)->slots);
+  VG_(free)(*T);
+  *T = NULL;
+}
+
+ULong LineContainer_Size(const LineContainer *T) {
+  return T->size;
+}
+
+LineObj* LineContainer_At(const LineContainer *T, ULong i) {
+  tl_assert(i < T->size);
+  return &T->pages[i >> LINECONTAINER_PAGE_SHIFT][i & LINECONTAINER_PAGE_MASK];
+}
+
+static void LineContainer_Grow(LineContainer *T) {
+  ULong i;
+  const ULong capacity = 2 * T->capacity;
+  LineObj **slots = VG_(calloc)("linectn.resize", capacity, sizeof(LineObj*));
+  for (i = 0; i < T->size; i++) {
+    LineObj *obj = LineContainer_At(T, i);
+    slots[findLineSlot(slots, capacity, &obj->key)] = obj;
+  }
+  VG_(free)(T->slots);
+  T->slots = slots;
+  T->capacity = capacity;
+}
+
+LineObj* LineContainer_Get(LineContainer *T, const LineKey *key) {
+  ULong slot = findLineSlot(T->slots, T->capacity, key);
+  if (T->slots[slot]) {
+    return T->slots[slot];
+  }
+
+  /* Keep the load factor under 1/2 */
+  if (2 * (T->size + 1) > T->capacity) {
+    LineContainer_Grow(T);
+    slot = findLineSlot(T->slots, T->capacity, key);
+  }
+  if (T->size == T->nbPages * LINECONTAINER_PAGE_SIZE) {
+    if (T->nbPages == T->dirCapacity) {
+      T->dirCapacity *= 2;
+      T->pages = VG_(realloc)("linectn.dir.resize", T->pages,
+			      T->dirCapacity * sizeof(LineObj*));
+    }
+    T->pages[T->nbPages] = VG_(malloc)("linectn.page",
+				       LINECONTAINER_PAGE_SIZE * sizeof(LineObj));
+    T->nbPages++;
+  }
+
+  LineObj *obj = &T->pages[T->size >> LINECONTAINER_PAGE_SHIFT]
+    [T->size & LINECONTAINER_PAGE_MASK];
+  obj->key = *key;
+  obj->count = 0;
+  obj->flops[0] = obj->flops[1] = 0;
+  T->slots[slot] = obj;
+  T->size++;
+  return obj;
 }
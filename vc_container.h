@@ -32,7 +32,9 @@
 #include "pub_tool_basics.h"
 #include "pub_tool_tooliface.h"
 #include "pub_tool_libcprint.h"
-#include "pub_tool_oset.h"
+#include "pub_tool_debuginfo.h"
+
+#include "vc_debuginfo.h"
 
 /* This module implements the containers used to store                         */
 /* the visited functions and the floating-point counters.                      */
@@ -42,51 +44,130 @@
 /*   - The "FPCounter" type that count the number of floating-point            */
 /*     operations for each number function (fun_no). This "fun_no"             */
 /*     is a unique ID for each function given by the associated "FnContainer". */
-/*     "FPCounter" implements a simple dynamic array.                          */
+/*     "FPCounter" implements a paged array: counters are stored in            */
+/*     contiguous pages of FPCOUNTER_PAGE_SIZE elements that are never         */
+/*     moved once allocated, so their addresses can be baked into the         */
+/*     translated code. Growing only reallocates the page directory.          */
 /*                                                                             */
-/*   - The "FnContainer" type that is a "OSetGen".                             */
+/*   - The "FnContainer" type that is an open-addressing hash table.           */
 /*     It holds object that records information about visited function         */
 /*     and gives a unique ID for each these functions.                         */
 /*     It uses two types:                                                      */
-/*     - "ContainerKey": Abstract type that identifes each object.             */
+/*     - "ContainerKey": The interned symbol ID of the function                */
+/*                       (see vc_debuginfo.h). Looking up a key costs a hash   */
+/*                       probe and no string comparison.                       */
 /*     - "ContainerObj": The object contained by the "FnContainer".            */
-/*       It records 4 fields:                                                  */
+/*       It records 5 fields:                                                  */
 /*       * key     : Key is unique for each object and is used for             */
 /*                   retreiving the object in the set.                         */
+/*       * name    : "dir/file:function" name of the function                  */
 /*       * function: Name of the function                                      */
 /*       * lib     : Name of the object file (library or binary)               */
 /*                   that contains the function                                */
+/*       * dir     : Path to the file                                          */
+/*       * file    : Name of the file and line of the function entry           */
 /*       * ID      : A unique number that identifies the object.               */
 /*                   This ID is used to index the "FPCounter".                 */
+/*                   IDs are given in insertion order, starting at 0,          */
+/*                   independently for each container.                         */
+/*                                                                             */
+/*   - The "LineContainer" type that is an open-addressing hash table of       */
+/*     source lines, identified by "LineKey" (function number, file, line and  */
+/*     optionally the instruction address). Each "LineObj" holds its counter,  */
+/*     objects are allocated in pages and never moved.                         */
        
 /*--------------------------------------------------------------------*/
 /*--- Types                                                        ---*/
 /*--------------------------------------------------------------------*/
 
-#define MAX_NAME_LENGTH 256
-#define INIT_SIZE_FPCOUNTER 1024
+#define FPCOUNTER_PAGE_SHIFT 10
+#define FPCOUNTER_PAGE_SIZE (1ULL << FPCOUNTER_PAGE_SHIFT)
+#define FPCOUNTER_PAGE_MASK (FPCOUNTER_PAGE_SIZE - 1)
+#define INIT_SIZE_FPCOUNTER_DIR 64
+#define INIT_SIZE_FNCONTAINER 1024
+#define LINECONTAINER_PAGE_SHIFT 8
+#define LINECONTAINER_PAGE_SIZE (1ULL << LINECONTAINER_PAGE_SHIFT)
+#define LINECONTAINER_PAGE_MASK (LINECONTAINER_PAGE_SIZE - 1)
+#define INIT_SIZE_LINECONTAINER 1024
 
-typedef ULong* FPCounterData;
+typedef ULong* FPCounterPage;
 
-/* Structure that implements a simple dynamic array */
+/* Structure that implements a paged array         */
+/* - pages      : Directory of the allocated pages */
+/* - nbPages    : Number of allocated pages        */
+/* - dirCapacity: Capacity of the directory        */
+/* - size       : Number of elements               */
 typedef struct _FPCounter FPCounter;
 struct _FPCounter {
-  FPCounterData data;
+  FPCounterPage *pages;
+  ULong nbPages;
+  ULong dirCapacity;
   ULong size;
-  ULong capacity;
 };
 
 /* Container that record visited functions */
-typedef HChar* ContainerKey;
+typedef ULong ContainerKey;
 typedef struct _ContainerObj ContainerObj;
 struct _ContainerObj {
   ContainerKey key;
-  HChar functionName[MAX_NAME_LENGTH];
-  HChar libName[MAX_NAME_LENGTH];
+  HChar *name;
+  const HChar *functionName;
+  const HChar *libName;
+  const HChar *dirName;
+  const HChar *fileName;
+  UInt line;
   ULong ID;
 };
 
-typedef OSet FnContainer; 
+/* - slots   : Hash table of capacity entries (power of 2)  */
+/* - objs    : Objects indexed by ID                        */
+/* - sorted  : Objects sorted by name, built by the iterator */
+typedef struct _FnContainer FnContainer;
+struct _FnContainer {
+  ContainerObj **slots;
+  ULong capacity;
+  ContainerObj **objs;
+  ContainerObj **sorted;
+  ULong size;
+  ULong objsCapacity;
+  ULong iter;
+};
+
+/* Source line of a function                             */
+/* - funNo: Number of the function (see FnContainer)     */
+/* - file : Interned name of the source file             */
+/* - line : Line in the file                             */
+/* - addr : Address of the instruction, 0 if the counts  */
+/*          of the line are not split by instruction     */
+/* The object holds the FP count of the line and its     */
+/* FLOPs in binary32 and binary64                        */
+typedef struct _LineKey LineKey;
+struct _LineKey {
+  ULong funNo;
+  const HChar *file;
+  UInt line;
+  Addr addr;
+};
+
+typedef struct _LineObj LineObj;
+struct _LineObj {
+  LineKey key;
+  ULong count;
+  ULong flops[2];
+};
+
+/* - slots  : Hash table of capacity entries (power of 2)   */
+/* - pages  : Objects in insertion order, in pages of       */
+/*            LINECONTAINER_PAGE_SIZE objects               */
+typedef struct _LineContainer LineContainer;
+struct _LineContainer {
+  LineObj **slots;
+  ULong capacity;
+  LineObj **pages;
+  ULong nbPages;
+  ULong dirCapacity;
+  ULong size;
+};
 
 /*--------------------------------------------------------------------*/
 /*--- Creating and destroying FPCounter                            ---*/
@@ -110,10 +191,22 @@ void free_FPCounter(FPCounter **T);
 /* - Size: The number of element in FPCounter        */
 /*                                                   */
 /* - Increment: Increment the size of the FPCounter. */
-/*              Resizes it if size >= capacity       */
+/*              Allocates a new page if needed, the  */
+/*              existing elements are not moved      */
+/*                                                   */
+/* - Addr: Returns the address of the i-th element.  */
+/*         It is stable for the life of the counter  */
+/*                                                   */
+/* - Get: Returns the value of the i-th element      */
+/*                                                   */
+/* - Reset: Sets all the elements to 0, the size and */
+/*          the addresses are kept                   */
   
 ULong size_FPCounter(const FPCounter *T);
 void increment_FPCounter(FPCounter *T);
+ULong* addr_FPCounter(const FPCounter *T, ULong i);
+ULong get_FPCounter(const FPCounter *T, ULong i);
+void reset_FPCounter(FPCounter *T);
 
 /*--------------------------------------------------------------------*/
 /*--- Creating and destroying FnCounter                            ---*/
@@ -148,19 +241,38 @@ ContainerObj* ContainerObj_New(FnContainer *T,
 /*--------------------------------------------------------------------*/
 
 /* - HasObj: Determines if an object with this key is in the container */
+/* - Lookup: Returns the object with this key or NULL                  */
 /* - Size: Returns the number of elements in the container             */
 /* - ID: Returns the ID associated with the given key                  */
 /*       Raises an error if the key is not in the container            */
 /* - Insert: Inserts the object in the container                       */
 /* - ResetIterator: Reset the iterator associated with the container   */
+/*                  Objects are iterated in the order of their name    */
 /* - Next: Returns the next element in the container and increments    */
 /*         its internal iterator                                       */
 
 Bool FnContainer_HasObj(const FnContainer *T, const ContainerKey *key);
+ContainerObj* FnContainer_Lookup(const FnContainer *T, const ContainerKey *key);
 UInt FnContainer_Size(const FnContainer *T);
 ULong FnContainer_ID(const FnContainer *T, const ContainerKey *key);
 void FnContainer_Insert(FnContainer *T, ContainerObj *obj);
 void FnContainer_ResetIterator(FnContainer *T);
 ContainerObj* FnContainer_Next(FnContainer *T);
 
+/*--------------------------------------------------------------------*/
+/*--- Operations on LineContainer                                  ---*/
+/*--------------------------------------------------------------------*/
+
+/* - Init, Free: allocates and frees a LineContainer                */
+/* - Get: Returns the object with this key, inserted with a null    */
+/*        counter if needed. Its address is stable                  */
+/* - Size: Returns the number of objects                            */
+/* - At: Returns the i-th object, in insertion order                */
+
+void LineContainer_Init(LineContainer **T);
+void LineContainer_Free(LineContainer **T);
+LineObj* LineContainer_Get(LineContainer *T, const LineKey *key);
+ULong LineContainer_Size(const LineContainer *T);
+LineObj* LineContainer_At(const LineContainer *T, ULong i);
+
 #endif /* __VC_CONTAINER_H__ */
@@ -0,0 +1,312 @@
+/*--------------------------------------------------------------------*/
+/*--- Vericheck: The FP profiler Valgrind tool.         vc_context.c ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Vericheck, the FP profiler Valgrind tool,
+   which does floating-point profiling.
+
+   Copyright (C) 2020 Yohan Chatelain
+      yohan.chatelain@gmail.com
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+
+#include "pub_tool_basics.h"
+#include "pub_tool_libcassert.h"
+#include "pub_tool_libcbase.h"
+#include "pub_tool_libcprint.h"
+#include "pub_tool_mallocfree.h"
+
+#include "vc_context.h"
+#include "vc_debuginfo.h"
+
+#define INIT_SIZE_CONTEXTS 1024
+#define INIT_SIZE_SHADOW_STACK 256
+
+/* Shadow stack of a thread                   */
+/* - stack: Contexts of the callers           */
+/* - sp   : Number of contexts in the stack   */
+/* - cur  : Context of the thread             */
+/* - pendingSp: sp after the call of the      */
+/*              pending callee, 0 if none     */
+typedef struct _ShadowStack ShadowStack;
+struct _ShadowStack {
+  CtxNode **stack;
+  UInt sp;
+  UInt capacity;
+  CtxNode *cur;
+  UInt pendingSp;
+};
+
+CtxNode *curCtxNode = NULL;
+UInt contextPending = 0;
+
+static UInt contextDepth = 0;
+static CtxNode *rootCtx = NULL;
+
+/* Open-addressing table of the contexts, hashed by path */
+static CtxNode **contexts = NULL;
+static ULong nbContexts = 0;
+static ULong contextsCapacity = 0;
+
+/* Shadow stacks indexed by ThreadId */
+static ShadowStack *shadowStacks = NULL;
+static ShadowStack *curShadowStack = NULL;
+
+static UWord hashPath(const ULong *symIds, UInt depth) {
+  UInt i;
+  UWord h = 2166136261UL;
+  for (i = 0; i < depth; i++) {
+    h = (h ^ symIds[i]) * 16777619UL;
+  }
+  return h;
+}
+
+static Bool samePath(const CtxNode *node, const ULong *symIds, UInt depth) {
+  UInt i;
+  if (node->depth != depth) {
+    return False;
+  }
+  for (i = 0; i < depth; i++) {
+    if (node->symIds[i] != symIds[i]) {
+      return False;
+    }
+  }
+  return True;
+}
+
+static void insertContext(CtxNode **table, ULong capacity, CtxNode *node) {
+  UWord i = hashPath(node->symIds, node->depth) & (capacity - 1);
+  while (table[i]) {
+    i = (i + 1) & (capacity - 1);
+  }
+  table[i] = node;
+}
+
+/* Returns the context of the path, created if needed */
+static CtxNode* getContext(const ULong *symIds, const HChar **names, UInt depth) {
+  UWord i;
+  CtxNode *node;
+
+  i = hashPath(symIds, depth) & (contextsCapacity - 1);
+  while ( (node = contexts[i]) ) {
+    if (samePath(node, symIds, depth)) {
+      return node;
+    }
+    i = (i + 1) & (contextsCapacity - 1);
+  }
+
+  node = VG_(calloc)("context.node", 1, sizeof(CtxNode));
+  node->depth = depth;
+  for (i = 0; i < depth; i++) {
+    node->symIds[i] = symIds[i];
+    node->names[i] = names[i];
+  }
+
+  /* Keep the load factor under 1/2 */
+  if (2 * (nbContexts + 1) > contextsCapacity) {
+    const ULong capacity = 2 * contextsCapacity;
+    CtxNode **table = VG_(calloc)("context.table", capacity, sizeof(CtxNode*));
+    for (i = 0; i < contextsCapacity; i++) {
+      if (contexts[i]) {
+	insertContext(table, capacity, contexts[i]);
+      }
+    }
+    VG_(free)(contexts);
+    contexts = table;
+    contextsCapacity = capacity;
+  }
+  insertContext(contexts, contextsCapacity, node);
+  nbContexts++;
+  return node;
+}
+
+void init_Context(UInt depth) {
+  tl_assert(depth <= MAX_CONTEXT_DEPTH);
+  contextDepth = depth;
+  contextsCapacity = INIT_SIZE_CONTEXTS;
+  contexts = VG_(calloc)("context.init", contextsCapacity, sizeof(CtxNode*));
+  nbContexts = 0;
+  rootCtx = getContext(NULL, NULL, 0);
+  shadowStacks = VG_(calloc)("context.stacks", VG_N_THREADS, sizeof(ShadowStack));
+  Context_SwitchThread(1);
+}
+
+void free_Context(void) {
+  ULong i;
+  for (i = 0; i < contextsCapacity; i++) {
+    if (contexts[i]) {
+      VG_(free)(contexts[i]);
+    }
+  }
+  VG_(free)(contexts);
+  for (i = 0; i < VG_N_THREADS; i++) {
+    if (shadowStacks[i].stack) {
+      VG_(free)(shadowStacks[i].stack);
+    }
+  }
+  VG_(free)(shadowStacks);
+  contexts = NULL;
+  shadowStacks = NULL;
+  curShadowStack = NULL;
+  curCtxNode = rootCtx = NULL;
+  contextPending = 0;
+}
+
+void Context_SwitchThread(ThreadId tid) {
+  tl_assert(tid < VG_N_THREADS);
+  if (curShadowStack) {
+    curShadowStack->cur = curCtxNode;
+  }
+  curShadowStack = &shadowStacks[tid];
+  if (curShadowStack->stack == NULL) {
+    curShadowStack->capacity = INIT_SIZE_SHADOW_STACK;
+    curShadowStack->stack = VG_(malloc)("context.stack",
+					curShadowStack->capacity * sizeof(CtxNode*));
+    curShadowStack->sp = 0;
+    curShadowStack->cur = rootCtx;
+    curShadowStack->pendingSp = 0;
+  }
+  curCtxNode = curShadowStack->cur;
+  contextPending = (curShadowStack->pendingSp > 0);
+}
+
+/* Returns the context entered by calling target from cur */
+static CtxNode* calleeContext(CtxNode *cur, Addr target) {
+  ULong symIds[MAX_CONTEXT_DEPTH];
+  const HChar *names[MAX_CONTEXT_DEPTH];
+  UInt i, depth, first;
+
+  /* The path of the callee is the last depth-1 functions */
+  /* of the caller followed by the callee                 */
+  const DebugInfo *di = getDebugInfoAt(target);
+  first = (cur->depth == contextDepth) ? 1 : 0;
+  depth = 0;
+  for (i = first; i < cur->depth; i++, depth++) {
+    symIds[depth] = cur->symIds[i];
+    names[depth] = cur->names[i];
+  }
+  symIds[depth] = di->symId;
+  names[depth] = di->function;
+  depth++;
+
+  CtxNode *child = getContext(symIds, names, depth);
+  cur->lastTarget = target;
+  cur->lastChild = child;
+  return child;
+}
+
+VG_REGPARM(1) void Context_Call(Addr target) {
+  ShadowStack *ss = curShadowStack;
+  if (ss->sp == ss->capacity) {
+    ss->capacity *= 2;
+    ss->stack = VG_(realloc)("context.stack", ss->stack,
+			     ss->capacity * sizeof(CtxNode*));
+  }
+  ss->stack[ss->sp++] = curCtxNode;
+  if (curCtxNode->lastChild && curCtxNode->lastTarget == target) {
+    curCtxNode = curCtxNode->lastChild;
+    return;
+  }
+  /* A stub has no name, the callee stays pending and */
+  /* the counts go to the caller until its entry      */
+  if (curCtxNode->lastStub == target || !isFunctionEntryAt(target)) {
+    curCtxNode->lastStub = target;
+    ss->pendingSp = ss->sp;
+    contextPending = 1;
+    return;
+  }
+  curCtxNode = calleeContext(curCtxNode, target);
+}
+
+VG_REGPARM(0) void Context_Ret(void) {
+  ShadowStack *ss = curShadowStack;
+  if (ss->sp > 0) {
+    curCtxNode = ss->stack[--ss->sp];
+  }
+  /* Return from a callee that was never named */
+  if (ss->sp < ss->pendingSp) {
+    ss->pendingSp = 0;
+    contextPending = 0;
+  }
+}
+
+VG_REGPARM(1) void Context_Enter(Addr entry) {
+  ShadowStack *ss = curShadowStack;
+  /* Entries of functions called by the dynamic */
+  /* linker while binding the callee are deeper */
+  if (ss->sp != ss->pendingSp) {
+    return;
+  }
+  ss->pendingSp = 0;
+  contextPending = 0;
+  curCtxNode = calleeContext(curCtxNode, entry);
+}
+
+Bool Context_IsCalleeEntry(Addr addr) {
+  if (!isFunctionEntryAt(addr)) {
+    return False;
+  }
+  return !VG_STREQN(19, getDebugInfoAt(addr)->function, "_dl_runtime_resolve");
+}
+
+void Context_Reset(void) {
+  ULong i;
+  for (i = 0; i < contextsCapacity; i++) {
+    if (contexts[i]) {
+      contexts[i]->ieee = 0;
+      contexts[i]->interflop = 0;
+    }
+  }
+}
+
+static Int cmpContext(const void *a, const void *b) {
+  const CtxNode *x = *(const CtxNode* const*)a;
+  const CtxNode *y = *(const CtxNode* const*)b;
+  const ULong cx = x->ieee + x->interflop;
+  const ULong cy = y->ieee + y->interflop;
+  return (cx > cy) ? -1 : (cx < cy) ? 1 : 0;
+}
+
+void Context_Print(void) {
+  ULong i, n = 0;
+  UInt j;
+  CtxNode **sorted = VG_(malloc)("context.print", nbContexts * sizeof(CtxNode*));
+
+  for (i = 0; i < contextsCapacity; i++) {
+    if (contexts[i] && contexts[i]->ieee + contexts[i]->interflop > 0) {
+      sorted[n++] = contexts[i];
+    }
+  }
+  VG_(ssort)(sorted, n, sizeof(CtxNode*), cmpContext);
+
+  VG_(umsg)("%llu contexts with FP (depth %u, IEEE, Interflop)\n", n, contextDepth);
+  VG_(umsg)("-------------------------\n");
+  for (i = 0; i < n; i++) {
+    VG_(umsg)("\t* ");
+    if (sorted[i]->depth == 0) {
+      VG_(umsg)("(root)");
+    }
+    for (j = 0; j < sorted[i]->depth; j++) {
+      VG_(umsg)("%s%s", (j > 0) ? " > " : "", sorted[i]->names[j]);
+    }
+    VG_(umsg)(" : %llu %llu\n", sorted[i]->ieee, sorted[i]->interflop);
+  }
+  VG_(umsg)("-------------------------\n\n");
+  VG_(free)(sorted);
+}
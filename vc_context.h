@@ -0,0 +1,114 @@
+/*--------------------------------------------------------------------*/
+/*--- Vericheck: The FP profiler Valgrind tool.         vc_context.h ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Vericheck, the FP profiler Valgrind tool,
+   which does floating-point profiling.
+
+   Copyright (C) 2020 Yohan Chatelain
+      yohan.chatelain@gmail.com
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+
+#ifndef __VC_CONTEXT_H__
+#define __VC_CONTEXT_H__
+
+#include "pub_tool_basics.h"
+
+/* This module implements the calling-context tree (CCT).          */
+/*                                                                 */
+/* A context is the path of the last N functions of the call       */
+/* stack, N being the depth given to init_Context. Each context    */
+/* is a "CtxNode" that holds its FP counters.                      */
+/*                                                                 */
+/* The call stack is not walked: each thread has a shadow stack    */
+/* of contexts, pushed by Context_Call when a superblock ends with */
+/* a Ijk_Call and popped by Context_Ret on Ijk_Ret. The context of */
+/* the running thread is in curCtxNode, the instrumented code adds */
+/* its counts at (curCtxNode + offsetof(CtxNode, counter)).        */
+/* Calls and returns that do not match (longjmp, exceptions,       */
+/* tail calls) are tolerated: a return on an empty shadow stack    */
+/* stays in the root context.                                      */
+/*                                                                 */
+/* A call to an address that is not a function entry, such as the */
+/* PLT stub of a shared library function, leaves the callee        */
+/* pending: it is named by Context_Enter at the first function     */
+/* entry reached at the same stack depth, after the stub and the   */
+/* lazy binding of the dynamic linker.                             */
+
+#define MAX_CONTEXT_DEPTH 16
+
+/* Context                                                    */
+/* - ieee, interflop: FP counters of the context              */
+/* - depth          : Number of functions in the path         */
+/* - symIds         : Symbol IDs of the path, caller first    */
+/* - names          : Interned names of the path functions    */
+/* - lastTarget     : Last called address from this context   */
+/* - lastChild      : Context pushed for lastTarget           */
+/* - lastStub       : Last called address from this context   */
+/*                    that is not a function entry            */
+typedef struct _CtxNode CtxNode;
+struct _CtxNode {
+  ULong ieee;
+  ULong interflop;
+  UInt depth;
+  ULong symIds[MAX_CONTEXT_DEPTH];
+  const HChar *names[MAX_CONTEXT_DEPTH];
+  Addr lastTarget;
+  CtxNode *lastChild;
+  Addr lastStub;
+};
+
+/* Context of the running thread */
+extern CtxNode *curCtxNode;
+
+/* 1 if the running thread has a pending callee, the instrumented */
+/* code only calls Context_Enter when it is set                   */
+extern UInt contextPending;
+
+/* - Init: creates the tree with contexts of depth functions */
+/* - Free: frees the tree and the shadow stacks              */
+void init_Context(UInt depth);
+void free_Context(void);
+
+/* Selects the shadow stack of the thread tid */
+void Context_SwitchThread(ThreadId tid);
+
+/* Helpers called from the instrumented code                 */
+/* - Call : enters the function at target                    */
+/* - Ret  : returns to the caller                            */
+/* - Enter: the function entry is reached, names the pending */
+/*          callee if any                                    */
+VG_REGPARM(1) void Context_Call(Addr target);
+VG_REGPARM(0) void Context_Ret(void);
+VG_REGPARM(1) void Context_Enter(Addr entry);
+
+/* Returns True if the superblock at addr must call Context_Enter: */
+/* addr is a function entry, other than the lazy binding resolver  */
+/* of the dynamic linker that is reached through the PLT as well   */
+Bool Context_IsCalleeEntry(Addr addr);
+
+/* Sets the counters of all the contexts to 0, the contexts */
+/* and the shadow stacks are kept                           */
+void Context_Reset(void);
+
+/* Prints the contexts with FP operations, by decreasing count */
+void Context_Print(void);
+
+#endif /* __VC_CONTEXT_H__ */
@@ -30,60 +30,401 @@
 
 #include "pub_tool_libcprint.h"
 #include "pub_tool_libcbase.h"
+#include "pub_tool_libcassert.h"
 #include "pub_tool_debuginfo.h"
 #include "pub_tool_tooliface.h"
 #include "pub_tool_threadstate.h"
+#include "pub_tool_oset.h"
+#include "pub_tool_xarray.h"
 
 #define UNK_STR "???"
 #define UNK_LINE 0
 
-DebugInfo* getDebugInfoTidAt(ThreadId tid, Addr addr) {
+/*--------------------------------------------------------------------*/
+/*--- Interned strings and symbols                                 ---*/
+/*--------------------------------------------------------------------*/
 
-  DebugInfo *di = (DebugInfo*)VG_(malloc)("init.di", sizeof(DebugInfo));
+/* Both tables use open addressing with linear probing.  */
+/* Their capacity is a power of 2 and they are doubled   */
+/* when they are half full. Entries are never removed.   */
+#define INIT_SIZE_INTERN_TABLE 1024
 
-  di->lib = UNK_STR;
-  di->dir = UNK_STR;
-  di->function = UNK_STR;
-  di->file = UNK_STR;
-  di->line = 0;
-  di->isEntry = False;
-  
-  if (addr == 0) {
-    VG_(get_StackTrace)(tid, &addr, 0, NULL, NULL, 0);
+/* Symbol identified by its interned strings */
+typedef struct _Symbol Symbol;
+struct _Symbol {
+  const HChar *lib;
+  const HChar *dir;
+  const HChar *file;
+  const HChar *function;
+  ULong id;
+};
+
+static const HChar **stringTable = NULL;
+static UWord stringTableCapacity = 0;
+static UWord nbStrings = 0;
+
+static Symbol **symbolTable = NULL;
+static UWord symbolTableCapacity = 0;
+static UWord nbSymbols = 0;
+
+/* FNV-1a hash */
+static UWord hashString(const HChar *str) {
+  UWord h = 2166136261UL;
+  for (; *str; str++) {
+    h = (h ^ (UChar)*str) * 16777619UL;
+  }
+  return h;
+}
+
+static UWord hashSymbol(const HChar *lib, const HChar *dir,
+			const HChar *file, const HChar *function) {
+  /* Interned strings are identified by their address */
+  UWord h = (UWord)lib;
+  h = h * 31 + (UWord)dir;
+  h = h * 31 + (UWord)file;
+  h = h * 31 + (UWord)function;
+  return h ^ (h >> 17);
+}
+
+static void growStringTable(void) {
+  UWord i, j;
+  const UWord oldCapacity = stringTableCapacity;
+  const HChar **oldTable = stringTable;
+
+  stringTableCapacity = (oldCapacity) ? 2 * oldCapacity : INIT_SIZE_INTERN_TABLE;
+  stringTable = VG_(calloc)("dicache.strings", stringTableCapacity,
+			    sizeof(HChar*));
+  for (i = 0; i < oldCapacity; i++) {
+    if (oldTable[i]) {
+      j = hashString(oldTable[i]) & (stringTableCapacity - 1);
+      while (stringTable[j]) {
+	j = (j + 1) & (stringTableCapacity - 1);
+      }
+      stringTable[j] = oldTable[i];
+    }
+  }
+  if (oldTable) {
+    VG_(free)(oldTable);
+  }
+}
+
+/* Returns the unique copy of str */
+static const HChar* internString(const HChar *str) {
+  UWord i;
+
+  if (2 * (nbStrings + 1) > stringTableCapacity) {
+    growStringTable();
+  }
+
+  i = hashString(str) & (stringTableCapacity - 1);
+  while (stringTable[i]) {
+    if (VG_(strcmp)(stringTable[i], str) == 0) {
+      return stringTable[i];
+    }
+    i = (i + 1) & (stringTableCapacity - 1);
+  }
+  stringTable[i] = VG_(strdup)("dicache.string", str);
+  nbStrings++;
+  return stringTable[i];
+}
+
+static void growSymbolTable(void) {
+  UWord i, j;
+  const UWord oldCapacity = symbolTableCapacity;
+  Symbol **oldTable = symbolTable;
+
+  symbolTableCapacity = (oldCapacity) ? 2 * oldCapacity : INIT_SIZE_INTERN_TABLE;
+  symbolTable = VG_(calloc)("dicache.symbols", symbolTableCapacity,
+			    sizeof(Symbol*));
+  for (i = 0; i < oldCapacity; i++) {
+    Symbol *sym = oldTable[i];
+    if (sym) {
+      j = hashSymbol(sym->lib, sym->dir, sym->file, sym->function)
+	& (symbolTableCapacity - 1);
+      while (symbolTable[j]) {
+	j = (j + 1) & (symbolTableCapacity - 1);
+      }
+      symbolTable[j] = sym;
+    }
+  }
+  if (oldTable) {
+    VG_(free)(oldTable);
+  }
+}
+
+/* Returns the symbol made of the interned strings */
+static const Symbol* internSymbol(const HChar *lib, const HChar *dir,
+				  const HChar *file, const HChar *function) {
+  UWord i;
+  Symbol *sym;
+
+  if (2 * (nbSymbols + 1) > symbolTableCapacity) {
+    growSymbolTable();
+  }
+
+  i = hashSymbol(lib, dir, file, function) & (symbolTableCapacity - 1);
+  while ( (sym = symbolTable[i]) ) {
+    if (sym->lib == lib && sym->dir == dir &&
+	sym->file == file && sym->function == function) {
+      return sym;
+    }
+    i = (i + 1) & (symbolTableCapacity - 1);
+  }
+  sym = VG_(malloc)("dicache.symbol", sizeof(Symbol));
+  sym->lib = lib;
+  sym->dir = dir;
+  sym->file = file;
+  sym->function = function;
+  symbolTable[i] = sym;
+  nbSymbols++;
+  sym->id = nbSymbols;
+  return sym;
+}
+
+ULong getAggregateSymId(const HChar *lib) {
+  const HChar *any = internString("*");
+  return internSymbol(internString(lib), any, any, any)->id;
+}
+
+/*--------------------------------------------------------------------*/
+/*--- Address range cache                                          ---*/
+/*--------------------------------------------------------------------*/
+
+/* Address range of a function recorded by the cache   */
+/* - start  : Entry address of the function            */
+/* - end    : One past the highest address looked up   */
+/* - atEntry: DebugInfo returned for start             */
+/* - inBody : DebugInfo returned for any other address */
+/* Both DebugInfo share the same interned strings      */
+typedef struct _DebugInfoRange DebugInfoRange;
+struct _DebugInfoRange {
+  Addr start;
+  Addr end;
+  DebugInfo atEntry;
+  DebugInfo inBody;
+};
+
+static const DebugInfo unknownDebugInfo = {
+  .lib = UNK_STR,
+  .dir = UNK_STR,
+  .file = UNK_STR,
+  .function = UNK_STR,
+  .line = UNK_LINE,
+  .isEntry = False,
+  .entry = 0,
+  .symId = UNK_SYMID
+};
+
+static OSet *debugInfoCache = NULL;
+/* Last range hit, checked before searching the set */
+static DebugInfoRange *lastRange = NULL;
+
+/* Compares an address to a range */
+/* Ranges never overlap since they are included in */
+/* the (disjoint) symbols of the debug information */
+static Word cmpAddr_DebugInfoRange(const void* key, const void* elem) {
+  const Addr a = *(const Addr*)key;
+  const DebugInfoRange *range = (const DebugInfoRange*)elem;
+  if (a < range->start) {
+    return -1;
+  } else if (a >= range->end) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+void initDebugInfoCache(void) {
+  debugInfoCache = VG_(OSetGen_Create)(offsetof(DebugInfoRange, start),
+				       cmpAddr_DebugInfoRange,
+				       VG_(malloc),
+				       "dicache.init",
+				       VG_(free));
+  lastRange = NULL;
+}
+
+static void freeDebugInfoRange(DebugInfoRange *range) {
+  VG_(OSetGen_FreeNode)(debugInfoCache, range);
+}
+
+void invalidateDebugInfoCache(Addr a, SizeT len) {
+  DebugInfoRange *range;
+  Word i;
+
+  if (debugInfoCache == NULL || len == 0) {
+    return;
+  }
+
+  /* The set cannot be modified while iterating */
+  XArray *dropped = VG_(newXA)(VG_(malloc), "dicache.invalidate",
+			       VG_(free), sizeof(Addr));
+  VG_(OSetGen_ResetIter)(debugInfoCache);
+  while ( (range = VG_(OSetGen_Next)(debugInfoCache)) ) {
+    if (range->start < a + len && a < range->end) {
+      VG_(addToXA)(dropped, &range->start);
+    }
   }
 
+  for (i = 0; i < VG_(sizeXA)(dropped); i++) {
+    const Addr *start = VG_(indexXA)(dropped, i);
+    range = VG_(OSetGen_Remove)(debugInfoCache, start);
+    tl_assert(range);
+    if (range == lastRange) {
+      lastRange = NULL;
+    }
+    freeDebugInfoRange(range);
+  }
+  VG_(deleteXA)(dropped);
+}
+
+void freeDebugInfoCache(void) {
+  DebugInfoRange *range;
+  if (debugInfoCache == NULL) {
+    return;
+  }
+  while ( VG_(OSetGen_Size)(debugInfoCache) > 0 ) {
+    VG_(OSetGen_ResetIter)(debugInfoCache);
+    range = VG_(OSetGen_Next)(debugInfoCache);
+    range = VG_(OSetGen_Remove)(debugInfoCache, &range->start);
+    freeDebugInfoRange(range);
+  }
+  VG_(OSetGen_Destroy)(debugInfoCache);
+  debugInfoCache = NULL;
+  lastRange = NULL;
+}
+
+/* Returns the DebugInfo of addr within range */
+static inline const DebugInfo* rangeDebugInfo(const DebugInfoRange *range,
+					      Addr addr) {
+  return (addr == range->start) ? &range->atEntry : &range->inBody;
+}
+
+/* Resolves the debug information of the function starting at entry */
+/* and records it as the range [entry, addr+1)                       */
+static DebugInfoRange* newDebugInfoRange(Addr entry, Addr addr) {
   const HChar *lib;
   const HChar *dir;
   const HChar *file;
   const HChar *function;
-  UInt line = 0;
-  
+  UInt line = UNK_LINE;
+
+  DebugInfoRange *range = VG_(OSetGen_AllocNode)(debugInfoCache,
+						 sizeof(DebugInfoRange));
+  range->start = entry;
+  range->end = addr + 1;
+  range->inBody = unknownDebugInfo;
+  range->inBody.entry = entry;
+
   DiEpoch ep = VG_(current_DiEpoch)();
-  Bool found_file_line = VG_(get_filename_linenum)(ep, addr, &file, &dir, &line);
-  Bool found_function = VG_(get_fnname)(ep, addr, &function);
-  Bool found_obj = VG_(get_objname)(ep, addr, &lib);
 
-  if (found_obj) {
-    di->lib = lib;
+  /* The strings returned by the debug info may only live until */
+  /* the next query, hence they are interned                    */
+  if (VG_(get_filename_linenum)(ep, entry, &file, &dir, &line)) {
+    range->inBody.dir = dir;
+    range->inBody.file = file;
+    range->inBody.line = line;
   }
-  if (found_function) {
-    di->function = function;
-    di->isEntry = VG_(get_fnname_if_entry)(ep, addr, &function);
+  range->inBody.dir = internString(range->inBody.dir);
+  range->inBody.file = internString(range->inBody.file);
+
+  if (VG_(get_fnname)(ep, entry, &function)) {
+    range->inBody.function = function;
   }
-    
-  if (found_file_line) {
-    di->dir = dir;
-    di->file = file;
-    di->line = line;
+  range->inBody.function = internString(range->inBody.function);
+
+  if (VG_(get_objname)(ep, entry, &lib)) {
+    range->inBody.lib = lib;
   }
+  range->inBody.lib = internString(range->inBody.lib);
+
+  const Symbol *sym = internSymbol(range->inBody.lib,
+				   range->inBody.dir,
+				   range->inBody.file,
+				   range->inBody.function);
+  range->inBody.symId = sym->id;
+
+  range->atEntry = range->inBody;
+  range->atEntry.isEntry = True;
+
+  VG_(OSetGen_Insert)(debugInfoCache, range);
+  return range;
+}
+
+const DebugInfo* getDebugInfoTidAt(ThreadId tid, Addr addr) {
 
-  return di;
+  DebugInfoRange *range;
+  PtrdiffT offset;
+
+  if (addr == 0) {
+    VG_(get_StackTrace)(tid, &addr, 0, NULL, NULL, 0);
+  }
+
+  if (debugInfoCache == NULL) {
+    initDebugInfoCache();
+  }
+
+  /* Fast paths: last range hit, then a single range search */
+  if (lastRange && lastRange->start <= addr && addr < lastRange->end) {
+    return rangeDebugInfo(lastRange, addr);
+  }
+
+  range = VG_(OSetGen_Lookup)(debugInfoCache, &addr);
+
+  if (range == NULL) {
+    DiEpoch ep = VG_(current_DiEpoch)();
+    if (!VG_(get_inst_offset_in_function)(ep, addr, &offset)) {
+      return &unknownDebugInfo;
+    }
+
+    const Addr entry = addr - offset;
+    range = VG_(OSetGen_Lookup)(debugInfoCache, &entry);
+    if (range && range->start == entry) {
+      /* Already known function: extends its range up to addr */
+      tl_assert(addr >= range->end);
+      range->end = addr + 1;
+    } else {
+      range = newDebugInfoRange(entry, addr);
+    }
+  }
+
+  lastRange = range;
+  return rangeDebugInfo(range, addr);
+}
+
+Bool isFunctionEntryAt(Addr addr) {
+  PtrdiffT offset;
+  const DebugInfoRange *range = NULL;
+
+  if (lastRange && lastRange->start <= addr && addr < lastRange->end) {
+    range = lastRange;
+  } else if (debugInfoCache) {
+    range = VG_(OSetGen_Lookup)(debugInfoCache, &addr);
+  }
+  if (range) {
+    return addr == range->start;
+  }
+
+  if (!VG_(get_inst_offset_in_function)(VG_(current_DiEpoch)(), addr, &offset)) {
+    return False;
+  }
+  return offset == 0;
+}
+
+Bool getLineAt(Addr addr, const HChar **file, UInt *line) {
+  const HChar *dir;
+  if (!VG_(get_filename_linenum)(VG_(current_DiEpoch)(), addr, file, &dir, line)) {
+    *file = internString("???");
+    *line = 0;
+    return False;
+  }
+  *file = internString(*file);
+  return True;
 }
 
-DebugInfo* getDebugInfoAt(Addr addr) {
+const DebugInfo* getDebugInfoAt(Addr addr) {
   return getDebugInfoTidAt(VG_(get_running_tid)(), addr);  
 }
 
-DebugInfo* getDebugInfo(void) {
+const DebugInfo* getDebugInfo(void) {
   return getDebugInfoAt(0);
 }
@@ -39,21 +39,64 @@
 /* - dir     : Path to the lib                        */
 /* - file    : Name of the file                       */
 /* - function: Name of the function                   */
-/* - line    : Line of the instruction                */
+/* - line    : Line of the function entry             */
 /* - isEntry : True if it's the first instruction     */
 /*             of the corresponding function          */
+/* - entry   : Address of the function entry          */
+/* - symId   : Unique ID of the symbol identified by  */
+/*             (lib, dir, file, function). It stays   */
+/*             the same if the object is remapped     */
+/* The returned DebugInfo are interned by the cache   */
+/* and must not be modified or freed by the caller.   */
+/* They remain valid until the code of the function   */
+/* is unmapped. The strings are interned as well and  */
+/* remain valid until the end of the execution.       */
+/* Symbol IDs start at 1, 0 is the unknown symbol */
+#define UNK_SYMID 0
+
 typedef struct _DebugInfo DebugInfo;
 struct _DebugInfo {
-  HChar *lib;
-  HChar *dir;
-  HChar *file;
-  HChar *function;
-  UInt *line;
+  const HChar *lib;
+  const HChar *dir;
+  const HChar *file;
+  const HChar *function;
+  UInt line;
   Bool isEntry;
+  Addr entry;
+  ULong symId;
 };
 
-DebugInfo* getDebugInfoTidAt(ThreadId tid, Addr addr);
-DebugInfo* getDebugInfoAt(Addr addr);
-DebugInfo* getDebugInfo(void);
+const DebugInfo* getDebugInfoTidAt(ThreadId tid, Addr addr);
+const DebugInfo* getDebugInfoAt(Addr addr);
+const DebugInfo* getDebugInfo(void);
+
+/* Symbol ID of the counter that aggregates all the functions */
+/* of the object lib. Its function is "*", which no real      */
+/* symbol has, so the ID never collides with a function.       */
+ULong getAggregateSymId(const HChar *lib);
+
+/* Returns True if addr is the entry of a function.  */
+/* Cheaper than getDebugInfoAt on a cache miss since */
+/* no name nor line is resolved.                     */
+Bool isFunctionEntryAt(Addr addr);
+
+/* Source line of the instruction at addr                  */
+/* Sets file to the interned name of the source file and   */
+/* line to its line. Returns False if there is no line     */
+/* information, file is then "???" and line 0.             */
+Bool getLineAt(Addr addr, const HChar **file, UInt *line);
+
+/* Debug info cache                                        */
+/* Each function seen so far is recorded as an address     */
+/* range [entry, end) where end grows as addresses of the  */
+/* function are looked up. Most lookups are a single range */
+/* search that does not allocate.                          */
+/* - init      : Creates the cache                         */
+/* - invalidate: Drops the functions overlapping [a, a+len)*/
+/*               Must be called when code is unmapped      */
+/* - free      : Frees the cache                           */
+void initDebugInfoCache(void);
+void invalidateDebugInfoCache(Addr a, SizeT len);
+void freeDebugInfoCache(void);
 
 #endif /* __VC_DEBUGINFO_H__ */
@@ -32,13 +32,588 @@
 #include "libvex_ir.h"
 
 #include "vc_fpops.h"
+#include "vc_utils.h"
+
+/*--------------------------------------------------------------------*/
+/*--- Descriptor table                                             ---*/
+/*--------------------------------------------------------------------*/
+
+/* Each FP operation is described once:                        */
+/* - class     : unary, binary, ternary, comparison, intrinsic */
+/* - precision : 32 or 64                                      */
+/* - lanes     : Number of elements of the vector register     */
+/* - llo       : Lowest-Lane-Only, only the first lane is      */
+/*               computed                                      */
+/* - arith     : Arithmetic operation {+,-,*,/,fma}            */
+/* - flops     : Number of FLOPs per computed lane, 0 for Neg  */
+/*               and Abs that only change the sign bit         */
+/* Operations that are not listed have a NONE class.           */
+
+#define OPDESC(o, cls, prec, nlanes, isllo, ar, nflops)			\
+  [Iop_##o - Iop_INVALID] = { .opClass = OPCLASS_##cls,			\
+			      .precision = prec,			\
+			      .lanes = nlanes,				\
+			      .llo = isllo,				\
+			      .arith = OPARITH_##ar,			\
+			      .flops = nflops,				\
+			      .name = #o }
+
+#define NB_OPS (Iop_LAST - Iop_INVALID)
+
+static const OpDesc opTable[NB_OPS] = {
+  /* Binary32 */
+
+  /* Scalar */
+  OPDESC(NegF32,           UNARY,     32, 1, False, OTHER, 0),
+  OPDESC(AbsF32,           UNARY,     32, 1, False, OTHER, 0),
+  OPDESC(AddF32,           BINARY,    32, 1, False, ADD,   1),
+  OPDESC(SubF32,           BINARY,    32, 1, False, SUB,   1),
+  OPDESC(MulF32,           BINARY,    32, 1, False, MUL,   1),
+  OPDESC(DivF32,           BINARY,    32, 1, False, DIV,   1),
+  OPDESC(CmpF32,           CMP,       32, 1, False, OTHER, 1),
+  OPDESC(MAddF32,          TERNARY,   32, 1, False, FMA,   2),
+  OPDESC(MSubF32,          TERNARY,   32, 1, False, FMA,   2),
+  OPDESC(SqrtF32,          INTRINSIC, 32, 1, False, OTHER, 1),
+  OPDESC(RecpExpF32,       INTRINSIC, 32, 1, False, OTHER, 1),
+
+  /* Lowest-Lane-Only */
+  OPDESC(Add32F0x4,        BINARY,    32, 4, True,  ADD,   1),
+  OPDESC(Sub32F0x4,        BINARY,    32, 4, True,  SUB,   1),
+  OPDESC(Mul32F0x4,        BINARY,    32, 4, True,  MUL,   1),
+  OPDESC(Div32F0x4,        BINARY,    32, 4, True,  DIV,   1),
+  OPDESC(CmpEQ32F0x4,      CMP,       32, 4, True,  OTHER, 1),
+  OPDESC(CmpLT32F0x4,      CMP,       32, 4, True,  OTHER, 1),
+  OPDESC(CmpLE32F0x4,      CMP,       32, 4, True,  OTHER, 1),
+  OPDESC(CmpUN32F0x4,      CMP,       32, 4, True,  OTHER, 1),
+  OPDESC(RecipEst32F0x4,   INTRINSIC, 32, 4, True,  OTHER, 1),
+  OPDESC(Sqrt32F0x4,       INTRINSIC, 32, 4, True,  OTHER, 1),
+  OPDESC(RSqrtEst32F0x4,   INTRINSIC, 32, 4, True,  OTHER, 1),
+
+  /* x2 */
+  OPDESC(Neg32Fx2,         UNARY,     32, 2, False, OTHER, 0),
+  OPDESC(Abs32Fx2,         UNARY,     32, 2, False, OTHER, 0),
+  OPDESC(Add32Fx2,         BINARY,    32, 2, False, ADD,   1),
+  OPDESC(Sub32Fx2,         BINARY,    32, 2, False, SUB,   1),
+  OPDESC(Mul32Fx2,         BINARY,    32, 2, False, MUL,   1),
+  OPDESC(CmpEQ32Fx2,       CMP,       32, 2, False, OTHER, 1),
+  OPDESC(CmpGT32Fx2,       CMP,       32, 2, False, OTHER, 1),
+  OPDESC(CmpGE32Fx2,       CMP,       32, 2, False, OTHER, 1),
+  OPDESC(RecipEst32Fx2,    INTRINSIC, 32, 2, False, OTHER, 1),
+  OPDESC(RecipStep32Fx2,   INTRINSIC, 32, 2, False, OTHER, 1),
+  OPDESC(RSqrtEst32Fx2,    INTRINSIC, 32, 2, False, OTHER, 1),
+  OPDESC(RSqrtStep32Fx2,   INTRINSIC, 32, 2, False, OTHER, 1),
+
+  /* x4 */
+  OPDESC(Neg32Fx4,         UNARY,     32, 4, False, OTHER, 0),
+  OPDESC(Abs32Fx4,         UNARY,     32, 4, False, OTHER, 0),
+  OPDESC(Add32Fx4,         BINARY,    32, 4, False, ADD,   1),
+  OPDESC(Sub32Fx4,         BINARY,    32, 4, False, SUB,   1),
+  OPDESC(Mul32Fx4,         BINARY,    32, 4, False, MUL,   1),
+  OPDESC(Div32Fx4,         BINARY,    32, 4, False, DIV,   1),
+  OPDESC(CmpEQ32Fx4,       CMP,       32, 4, False, OTHER, 1),
+  OPDESC(CmpLT32Fx4,       CMP,       32, 4, False, OTHER, 1),
+  OPDESC(CmpLE32Fx4,       CMP,       32, 4, False, OTHER, 1),
+  OPDESC(CmpUN32Fx4,       CMP,       32, 4, False, OTHER, 1),
+  OPDESC(CmpGT32Fx4,       CMP,       32, 4, False, OTHER, 1),
+  OPDESC(CmpGE32Fx4,       CMP,       32, 4, False, OTHER, 1),
+  OPDESC(Sqrt32Fx4,        INTRINSIC, 32, 4, False, OTHER, 1),
+  OPDESC(RecipEst32Fx4,    INTRINSIC, 32, 4, False, OTHER, 1),
+  OPDESC(RecipStep32Fx4,   INTRINSIC, 32, 4, False, OTHER, 1),
+  OPDESC(Scale2_32Fx4,     INTRINSIC, 32, 4, False, OTHER, 1),
+  OPDESC(Log2_32Fx4,       INTRINSIC, 32, 4, False, OTHER, 1),
+  OPDESC(Exp2_32Fx4,       INTRINSIC, 32, 4, False, OTHER, 1),
+  OPDESC(RSqrtStep32Fx4,   INTRINSIC, 32, 4, False, OTHER, 1),
+
+  /* x8 */
+  OPDESC(Add32Fx8,         BINARY,    32, 8, False, ADD,   1),
+  OPDESC(Sub32Fx8,         BINARY,    32, 8, False, SUB,   1),
+  OPDESC(Mul32Fx8,         BINARY,    32, 8, False, MUL,   1),
+  OPDESC(Div32Fx8,         BINARY,    32, 8, False, DIV,   1),
+  OPDESC(Sqrt32Fx8,        INTRINSIC, 32, 8, False, OTHER, 1),
+  OPDESC(RSqrtEst32Fx8,    INTRINSIC, 32, 8, False, OTHER, 1),
+  OPDESC(RecipEst32Fx8,    INTRINSIC, 32, 8, False, OTHER, 1),
+
+  /* Binary64 */
+
+  /* Scalar */
+  OPDESC(NegF64,           UNARY,     64, 1, False, OTHER, 0),
+  OPDESC(AbsF64,           UNARY,     64, 1, False, OTHER, 0),
+  OPDESC(AddF64,           BINARY,    64, 1, False, ADD,   1),
+  OPDESC(SubF64,           BINARY,    64, 1, False, SUB,   1),
+  OPDESC(MulF64,           BINARY,    64, 1, False, MUL,   1),
+  OPDESC(DivF64,           BINARY,    64, 1, False, DIV,   1),
+  OPDESC(AddF64r32,        BINARY,    64, 1, False, ADD,   1),
+  OPDESC(SubF64r32,        BINARY,    64, 1, False, SUB,   1),
+  OPDESC(MulF64r32,        BINARY,    64, 1, False, MUL,   1),
+  OPDESC(DivF64r32,        BINARY,    64, 1, False, DIV,   1),
+  OPDESC(CmpF64,           CMP,       64, 1, False, OTHER, 1),
+  OPDESC(MAddF64,          TERNARY,   64, 1, False, FMA,   2),
+  OPDESC(MSubF64,          TERNARY,   64, 1, False, FMA,   2),
+  OPDESC(MAddF64r32,       TERNARY,   64, 1, False, FMA,   2),
+  OPDESC(MSubF64r32,       TERNARY,   64, 1, False, FMA,   2),
+  OPDESC(SqrtF64,          INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(AtanF64,          INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(Yl2xF64,          INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(Yl2xp1F64,        INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(PRemF64,          INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(PRemC3210F64,     INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(PRem1F64,         INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(PRem1C3210F64,    INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(ScaleF64,         INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(SinF64,           INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(CosF64,           INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(TanF64,           INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(2xm1F64,          INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(RSqrtEst5GoodF64, INTRINSIC, 64, 1, False, OTHER, 1),
+  OPDESC(RecpExpF64,       INTRINSIC, 64, 1, False, OTHER, 1),
+
+  /* Lowest-Lane-Only */
+  OPDESC(Add64F0x2,        BINARY,    64, 2, True,  ADD,   1),
+  OPDESC(Sub64F0x2,        BINARY,    64, 2, True,  SUB,   1),
+  OPDESC(Mul64F0x2,        BINARY,    64, 2, True,  MUL,   1),
+  OPDESC(Div64F0x2,        BINARY,    64, 2, True,  DIV,   1),
+  OPDESC(CmpEQ64F0x2,      CMP,       64, 2, True,  OTHER, 1),
+  OPDESC(CmpLT64F0x2,      CMP,       64, 2, True,  OTHER, 1),
+  OPDESC(CmpLE64F0x2,      CMP,       64, 2, True,  OTHER, 1),
+  OPDESC(CmpUN64F0x2,      CMP,       64, 2, True,  OTHER, 1),
+  OPDESC(Sqrt64F0x2,       INTRINSIC, 64, 2, True,  OTHER, 1),
+
+  /* x2 */
+  OPDESC(Neg64Fx2,         UNARY,     64, 2, False, OTHER, 0),
+  OPDESC(Abs64Fx2,         UNARY,     64, 2, False, OTHER, 0),
+  OPDESC(Add64Fx2,         BINARY,    64, 2, False, ADD,   1),
+  OPDESC(Sub64Fx2,         BINARY,    64, 2, False, SUB,   1),
+  OPDESC(Mul64Fx2,         BINARY,    64, 2, False, MUL,   1),
+  OPDESC(Div64Fx2,         BINARY,    64, 2, False, DIV,   1),
+  OPDESC(CmpEQ64Fx2,       CMP,       64, 2, False, OTHER, 1),
+  OPDESC(CmpLT64Fx2,       CMP,       64, 2, False, OTHER, 1),
+  OPDESC(CmpLE64Fx2,       CMP,       64, 2, False, OTHER, 1),
+  OPDESC(CmpUN64Fx2,       CMP,       64, 2, False, OTHER, 1),
+  OPDESC(Sqrt64Fx2,        INTRINSIC, 64, 2, False, OTHER, 1),
+  OPDESC(Scale2_64Fx2,     INTRINSIC, 64, 2, False, OTHER, 1),
+  OPDESC(Log2_64Fx2,       INTRINSIC, 64, 2, False, OTHER, 1),
+  OPDESC(RecipEst64Fx2,    INTRINSIC, 64, 2, False, OTHER, 1),
+  OPDESC(RecipStep64Fx2,   INTRINSIC, 64, 2, False, OTHER, 1),
+  OPDESC(RSqrtEst64Fx2,    INTRINSIC, 64, 2, False, OTHER, 1),
+  OPDESC(RSqrtStep64Fx2,   INTRINSIC, 64, 2, False, OTHER, 1),
+
+  /* x4 */
+  OPDESC(Add64Fx4,         BINARY,    64, 4, False, ADD,   1),
+  OPDESC(Sub64Fx4,         BINARY,    64, 4, False, SUB,   1),
+  OPDESC(Mul64Fx4,         BINARY,    64, 4, False, MUL,   1),
+  OPDESC(Div64Fx4,         BINARY,    64, 4, False, DIV,   1),
+  OPDESC(Sqrt64Fx4,        INTRINSIC, 64, 4, False, OTHER, 1),
+};
+
+static const OpDesc noneOpDesc = { .opClass = OPCLASS_NONE, .name = "unk" };
+
+/* Ops missing from opTable are zero-filled slots without a name, */
+/* they are all described by noneOpDesc                          */
+const OpDesc* vc_getOpDesc(const IROp op) {
+  if (op <= Iop_INVALID || op >= Iop_LAST
+      || opTable[op - Iop_INVALID].opClass == OPCLASS_NONE) {
+    return &noneOpDesc;
+  }
+  return &opTable[op - Iop_INVALID];
+}
+
+/* Unary, binary and ternary operations are arithmetic */
+static inline Bool isArithmeticClass(const UChar opClass) {
+  return opClass == OPCLASS_UNARY
+    || opClass == OPCLASS_BINARY
+    || opClass == OPCLASS_TERNARY;
+}
+
+/* Checks the descriptor of op                               */
+/* - opClass  : expected class, OPCLASS_NONE for arithmetic  */
+/* - precision: expected precision                           */
+/* - lanes    : expected number of lanes, 0 for any          */
+/* - lloOnly  : True if the op must be Lowest-Lane-Only      */
+static inline Bool matchOp(const IROp op, const OpClass opClass,
+			   const UChar precision, const UChar lanes,
+			   const Bool lloOnly) {
+  const OpDesc *desc = vc_getOpDesc(op);
+  if (desc->precision != precision) {
+    return False;
+  }
+  if (opClass == OPCLASS_NONE) {
+    if (!isArithmeticClass(desc->opClass)) {
+      return False;
+    }
+  } else if (desc->opClass != opClass) {
+    return False;
+  }
+  if (lanes != 0 && desc->lanes != lanes) {
+    return False;
+  }
+  return !lloOnly || desc->llo;
+}
+
+/* Binary32 */
+
+/* Scalar */
+Bool vc_isScalarUnaryOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_UNARY, 32, 1, False);
+}
+
+Bool vc_isScalarBinaryOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_BINARY, 32, 1, False);
+}
+
+Bool vc_isCmpOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_CMP, 32, 1, False);
+}
+
+Bool vc_isTernaryOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_TERNARY, 32, 0, False);
+}
+
+Bool vc_isScalarIntrinsicOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_INTRINSIC, 32, 1, False);
+}
+
+/* Lowest-Lane-Only */
+Bool vc_isLLOx4BinaryOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_BINARY, 32, 4, True);
+}
+
+Bool vc_isLLOx4CmpOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_CMP, 32, 4, True);
+}
+
+Bool vc_isLLOx4IntrinsicOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_INTRINSIC, 32, 4, True);
+}
+
+/* Vector */
+/* The vector predicates include the Lowest-Lane-Only ops */
+/* of the same width                                      */
+
+/* x2 */
+Bool vc_isVectorx2UnaryOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_UNARY, 32, 2, False);
+}
+
+Bool vc_isVectorx2BinaryOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_BINARY, 32, 2, False);
+}
+
+Bool vc_isVectorx2CmpOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_CMP, 32, 2, False);
+}
+
+Bool vc_isVectorx2IntrinsicOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_INTRINSIC, 32, 2, False);
+}
+
+/* x4 */
+Bool vc_isVectorx4UnaryOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_UNARY, 32, 4, False);
+}
+
+Bool vc_isVectorx4BinaryOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_BINARY, 32, 4, False);
+}
+
+Bool vc_isVectorx4CmpOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_CMP, 32, 4, False);
+}
+
+Bool vc_isVectorx4IntrinsicOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_INTRINSIC, 32, 4, False);
+}
+
+/* x8 */
+Bool vc_isVectorx8BinaryOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_BINARY, 32, 8, False);
+}
+
+Bool vc_isVectorx8IntrinsicOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_INTRINSIC, 32, 8, False);
+}
+
+/* Binary64 */
+
+/* Scalar */
+Bool vc_isScalarUnaryOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_UNARY, 64, 1, False);
+}
+
+Bool vc_isScalarBinaryOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_BINARY, 64, 1, False);
+}
+
+Bool vc_isCmpOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_CMP, 64, 1, False);
+}
+
+Bool vc_isTernaryOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_TERNARY, 64, 0, False);
+}
+
+Bool vc_isScalarIntrinsicOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_INTRINSIC, 64, 1, False);
+}
+
+/* Lowest-Lane-Only */
+Bool vc_isLLOx2BinaryOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_BINARY, 64, 2, True);
+}
+
+Bool vc_isLLOx2CompOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_CMP, 64, 2, True);
+}
+
+Bool vc_isLLOx2IntrinsicOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_INTRINSIC, 64, 2, True);
+}
+
+/* Vector */
+
+/* x2 */
+Bool vc_isVectorx2UnaryOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_UNARY, 64, 2, False);
+}
+
+Bool vc_isVectorx2BinaryOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_BINARY, 64, 2, False);
+}
+
+Bool vc_isVectorx2CompOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_CMP, 64, 2, False);
+}
+
+Bool vc_isVectorx2IntrinsicOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_INTRINSIC, 64, 2, False);
+}
+
+/* x4 */
+Bool vc_isVectorx4BinaryOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_BINARY, 64, 4, False);
+}
+
+Bool vc_isVectorx4IntrinsicOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_INTRINSIC, 64, 4, False);
+}
+
+/* Common functions */
+
+/* Arithmetics op tests funtions */
+/* OPCLASS_NONE matches unary, binary and ternary ops */
+
+/* Binary32 */
+
+Bool vc_isScalarArithmeticOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 32, 1, False);
+}
+
+Bool vc_isVectorx2ArithmeticOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 32, 2, False);
+}
+
+Bool vc_isVectorx4ArithmeticOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 32, 4, False);
+}
+
+Bool vc_isVectorx8ArithmeticOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 32, 8, False);
+}
+
+Bool vc_isLLOArithmeticOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 32, 0, True);
+}
+
+Bool vc_isVectorArithmeticOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 32, 0, False) && vc_getOpDesc(op)->lanes > 1;
+}
+
+Bool vc_isArithmeticOpF32(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 32, 0, False);
+}
+
+/* Binary64 */
+
+Bool vc_isScalarArithmeticOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 64, 1, False);
+}
+
+Bool vc_isVectorx2ArithmeticOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 64, 2, False);
+}
+
+Bool vc_isVectorx4ArithmeticOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 64, 4, False);
+}
+
+Bool vc_isVectorArithmeticOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 64, 0, False) && vc_getOpDesc(op)->lanes > 1;
+}
+
+Bool vc_isLLOArithmeticOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 64, 0, True);
+}
+
+Bool vc_isArithmeticOpF64(const IROp op) {
+  return matchOp(op, OPCLASS_NONE, 64, 0, False);
+}
+
+Bool vc_isArithmeticOpF(const IROp op) {
+  return isArithmeticClass(vc_getOpDesc(op)->opClass);
+}
+
+/* Type operators */
+
+Bool vc_isAddOp(const IROp op) {
+  return vc_getOpDesc(op)->arith == OPARITH_ADD;
+}
+
+Bool vc_isSubOp(const IROp op) {
+  return vc_getOpDesc(op)->arith == OPARITH_SUB;
+}
+
+Bool vc_isMulOp(const IROp op) {
+  return vc_getOpDesc(op)->arith == OPARITH_MUL;
+}
+
+Bool vc_isDivOp(const IROp op) {
+  return vc_getOpDesc(op)->arith == OPARITH_DIV;
+}
+
+Bool vc_isFmaOp(const IROp op) {
+  return vc_getOpDesc(op)->arith == OPARITH_FMA;
+}
+
+/* Return the size of the operands */
+/* Lowest-Lane-Only ops compute a single lane */
+ULong vc_getSizeArithmeticOp(const IROp op) {
+  const OpDesc *desc = vc_getOpDesc(op);
+  if (!isArithmeticClass(desc->opClass)) {
+    VG_(tool_panic)("Unknown arithmetic operator size");
+  }
+  return (desc->llo) ? 1 : desc->lanes;
+}
+
+/* Return the number of FLOPs of the operation */
+ULong vc_getFlopsArithmeticOp(const IROp op) {
+  return vc_getSizeArithmeticOp(op) * vc_getOpDesc(op)->flops;
+}
+
+/* Name functions */
+
+const HChar *vc_getTypeNameOp(const IROp op) {
+  switch (vc_getOpDesc(op)->precision) {
+  case 32:
+    return "b32";
+  case 64:
+    return "b64";
+  default:
+    VG_(umsg)("Unkonw type name %u",op);
+    return "ukn";
+  }
+}
+
+const HChar *vc_getDimTypeNameOp(const IROp op) {
+  const OpDesc *desc = vc_getOpDesc(op);
+  const UChar lanes = (desc->llo) ? 1 : desc->lanes;
+  switch (lanes) {
+  case 1:
+    return "x1";
+  case 2:
+    return "x2";
+  case 4:
+    return "x4";
+  case 8:
+    return "x8";
+  default:
+    VG_(umsg)("Unkonw operation dimension %u",op);
+    return "ukn";
+  }
+}
+
+const HChar *vc_getArithmeticNameOp(const IROp op) {
+  switch (vc_getOpDesc(op)->arith) {
+  case OPARITH_ADD:
+    return "add";
+  case OPARITH_SUB:
+    return "sub";
+  case OPARITH_MUL:
+    return "mul";
+  case OPARITH_DIV:
+    return "div";
+  case OPARITH_FMA:
+    return "fma";
+  default:
+    VG_(umsg)("Unknown operation type %u",op);
+    return "unk";
+  }
+}
+
+void vc_getNameOp(const IROp op, HChar *name) {
+  const HChar *type = vc_getTypeNameOp(op);
+  const HChar *dim = vc_getDimTypeNameOp(op);
+  const HChar *sym = vc_getArithmeticNameOp(op);
+  VG_(strcat)(name, type);
+  VG_(strcat)(name, sym);
+  VG_(strcat)(name, dim);
+}
+
+const HChar* vc_getRawNameOp(const IROp op) {
+  const OpDesc *desc = vc_getOpDesc(op);
+  if (desc->opClass == OPCLASS_NONE) {
+    VG_(umsg)("Unknown op %u\n", op);
+  }
+  return desc->name;
+}
+
+/* Op-mix cells */
+
+static const HChar *opMixPrecisionNames[OPMIX_NB_PRECISIONS] = {"b32", "b64"};
+static const HChar *opMixArithNames[OPMIX_NB_ARITHS] = {"add", "sub", "mul",
+							"div", "fma", "oth"};
+static const HChar *opMixWidthNames[OPMIX_NB_WIDTHS] = {"x1", "x2", "x4", "x8"};
+
+UInt vc_getOpMixCell(const IROp op) {
+  const OpDesc *desc = vc_getOpDesc(op);
+  UInt precision, arith, width;
+
+  if (!isArithmeticClass(desc->opClass)) {
+    VG_(tool_panic)("Op-mix cell of a non arithmetic operator");
+  }
+  precision = (desc->precision == 32) ? 0 : 1;
+  /* OPARITH_OTHER is 0, it is moved at the end */
+  arith = (desc->arith == OPARITH_OTHER) ? OPMIX_NB_ARITHS - 1 : desc->arith - 1;
+  switch ((desc->llo) ? 1 : desc->lanes) {
+  case 1:  width = 0; break;
+  case 2:  width = 1; break;
+  case 4:  width = 2; break;
+  default: width = 3; break;
+  }
+  return (precision * OPMIX_NB_ARITHS + arith) * OPMIX_NB_WIDTHS + width;
+}
+
+void vc_getOpMixCellName(const UInt cell, HChar *name) {
+  const UInt width = cell % OPMIX_NB_WIDTHS;
+  const UInt arith = (cell / OPMIX_NB_WIDTHS) % OPMIX_NB_ARITHS;
+  const UInt precision = cell / (OPMIX_NB_WIDTHS * OPMIX_NB_ARITHS);
+  tl_assert(cell < OPMIX_NB_CELLS);
+  VG_(sprintf)(name, "%s%s%s", opMixPrecisionNames[precision],
+	       opMixArithNames[arith], opMixWidthNames[width]);
+}
+
+/*--------------------------------------------------------------------*/
+/*--- Reference predicates                                         ---*/
+/*--------------------------------------------------------------------*/
+
+/* Switch-based predicates, only used by vc_checkOpTable to check */
+/* that the descriptor table gives the same classification.       */
+/* An op added to the table must be added here as well.           */
 
 /* Binary32 */
 
 /* Scalar */
 
 /* Unary */
-Bool vc_isScalarUnaryOpF32(const IROp op) {
+static Bool ref_isScalarUnaryOpF32(const IROp op) {
   switch (op) {
   case Iop_NegF32:
   case Iop_AbsF32:
@@ -49,7 +624,7 @@ Bool vc_isScalarUnaryOpF32(const IROp op) {
 }
 
 /* Binary */
-Bool vc_isScalarBinaryOpF32(const IROp op) {
+static Bool ref_isScalarBinaryOpF32(const IROp op) {
   switch (op) {
   case Iop_AddF32:
   case Iop_SubF32:
@@ -62,7 +637,7 @@ Bool vc_isScalarBinaryOpF32(const IROp op) {
 }
 
 /* Comparisons */
-Bool vc_isCmpOpF32(const IROp op) {
+static Bool ref_isCmpOpF32(const IROp op) {
   switch (op) {
   case Iop_CmpF32:
     return True;
@@ -72,7 +647,7 @@ Bool vc_isCmpOpF32(const IROp op) {
 }
 
 /* Ternary */
-Bool vc_isTernaryOpF32(const IROp op) {
+static Bool ref_isTernaryOpF32(const IROp op) {
   switch (op) {
   case Iop_MAddF32:
   case Iop_MSubF32:
@@ -83,7 +658,7 @@ Bool vc_isTernaryOpF32(const IROp op) {
 }
 
 /* Intrinsics */
-Bool vc_isScalarIntrinsicOpF32(const IROp op) {
+static Bool ref_isScalarIntrinsicOpF32(const IROp op) {
   switch (op) {
   case Iop_SqrtF32:
   case Iop_RecpExpF32:
@@ -97,7 +672,7 @@ Bool vc_isScalarIntrinsicOpF32(const IROp op) {
 /* Vector with one active element */
 
 /* Binary */
-Bool vc_isLLOx4BinaryOpF32(const IROp op) {
+static Bool ref_isLLOx4BinaryOpF32(const IROp op) {
   switch (op) {
   case Iop_Add32F0x4:
   case Iop_Sub32F0x4:
@@ -110,7 +685,7 @@ Bool vc_isLLOx4BinaryOpF32(const IROp op) {
 }
 
 /* Comparisons */
-Bool vc_isLLOx4CmpOpF32(const IROp op) {
+static Bool ref_isLLOx4CmpOpF32(const IROp op) {
   switch (op) {
   case Iop_CmpEQ32F0x4:
   case Iop_CmpLT32F0x4:
@@ -123,7 +698,7 @@ Bool vc_isLLOx4CmpOpF32(const IROp op) {
 }
 
 /* Intrinsics */
-Bool vc_isLLOx4IntrinsicOpF32(const IROp op) {
+static Bool ref_isLLOx4IntrinsicOpF32(const IROp op) {
   switch (op) {
   case Iop_RecipEst32F0x4:
   case Iop_Sqrt32F0x4:
@@ -139,7 +714,7 @@ Bool vc_isLLOx4IntrinsicOpF32(const IROp op) {
 /* x2 */
 
 /* Unary */
-Bool vc_isVectorx2UnaryOpF32(const IROp op) {
+static Bool ref_isVectorx2UnaryOpF32(const IROp op) {
   switch (op) {
   case Iop_Neg32Fx2:
   case Iop_Abs32Fx2:
@@ -150,7 +725,7 @@ Bool vc_isVectorx2UnaryOpF32(const IROp op) {
 }
 
 /* Binary */
-Bool vc_isVectorx2BinaryOpF32(const IROp op) {
+static Bool ref_isVectorx2BinaryOpF32(const IROp op) {
   switch (op) {
   case Iop_Add32Fx2:
   case Iop_Sub32Fx2:
@@ -162,7 +737,7 @@ Bool vc_isVectorx2BinaryOpF32(const IROp op) {
 }
 
 /* Comparisons */
-Bool vc_isVectorx2CmpOpF32(const IROp op) {
+static Bool ref_isVectorx2CmpOpF32(const IROp op) {
   switch (op) {
   case Iop_CmpEQ32Fx2:
   case Iop_CmpGT32Fx2:
@@ -174,7 +749,7 @@ Bool vc_isVectorx2CmpOpF32(const IROp op) {
 }
 
 /* Intrinsics */
-Bool vc_isVectorx2IntrinsicOpF32(const IROp op) {
+static Bool ref_isVectorx2IntrinsicOpF32(const IROp op) {
   switch (op) {
   case Iop_RecipEst32Fx2: /* Vector Reciprocal EStimated */
   case Iop_RecipStep32Fx2:
@@ -189,7 +764,7 @@ Bool vc_isVectorx2IntrinsicOpF32(const IROp op) {
 /* x4 */
 
 /* Unary */
-Bool vc_isVectorx4UnaryOpF32(const IROp op) {
+static Bool ref_isVectorx4UnaryOpF32(const IROp op) {
   switch (op) {
   case Iop_Neg32Fx4:
   case Iop_Abs32Fx4:
@@ -200,7 +775,7 @@ Bool vc_isVectorx4UnaryOpF32(const IROp op) {
 }
 
 /* Binary */
-Bool vc_isVectorx4BinaryOpF32(const IROp op) {
+static Bool ref_isVectorx4BinaryOpF32(const IROp op) {
   switch (op) {
   case Iop_Add32Fx4:
   case Iop_Sub32Fx4:
@@ -217,7 +792,7 @@ Bool vc_isVectorx4BinaryOpF32(const IROp op) {
 }
 
 /* Comparisons */
-Bool vc_isVectorx4CmpOpF32(const IROp op) {
+static Bool ref_isVectorx4CmpOpF32(const IROp op) {
   switch (op) {
   case Iop_CmpEQ32Fx4:
   case Iop_CmpLT32Fx4:
@@ -237,7 +812,7 @@ Bool vc_isVectorx4CmpOpF32(const IROp op) {
 
 
 /* Intrinsics */
-Bool vc_isVectorx4IntrinsicOpF32(const IROp op) {
+static Bool ref_isVectorx4IntrinsicOpF32(const IROp op) {
   switch (op) {
   case Iop_Sqrt32Fx4:
   case Iop_RecipEst32Fx4:
@@ -260,7 +835,7 @@ Bool vc_isVectorx4IntrinsicOpF32(const IROp op) {
 /* Unary*/
 
 /* Binary */
-Bool vc_isVectorx8BinaryOpF32(const IROp op) {
+static Bool ref_isVectorx8BinaryOpF32(const IROp op) {
   switch (op) {
   case Iop_Add32Fx8:
   case Iop_Sub32Fx8:
@@ -273,7 +848,7 @@ Bool vc_isVectorx8BinaryOpF32(const IROp op) {
 }
 
 /* Intrinsics */
-Bool vc_isVectorx8IntrinsicOpF32(const IROp op) {
+static Bool ref_isVectorx8IntrinsicOpF32(const IROp op) {
   switch (op) {
   case Iop_Sqrt32Fx8:
   case Iop_RSqrtEst32Fx8:
@@ -289,7 +864,7 @@ Bool vc_isVectorx8IntrinsicOpF32(const IROp op) {
 /* Scalar */
 
 /* Unary */
-Bool vc_isScalarUnaryOpF64(const IROp op) {
+static Bool ref_isScalarUnaryOpF64(const IROp op) {
   switch (op) {
   case Iop_NegF64:
   case Iop_AbsF64:
@@ -300,7 +875,7 @@ Bool vc_isScalarUnaryOpF64(const IROp op) {
 }
 
 /* Binary */
-Bool vc_isScalarBinaryOpF64(const IROp op) {
+static Bool ref_isScalarBinaryOpF64(const IROp op) {
   switch (op) {
   case Iop_AddF64:
   case Iop_SubF64:
@@ -317,7 +892,7 @@ Bool vc_isScalarBinaryOpF64(const IROp op) {
 }
 
 /* Comparisons */
-Bool vc_isCmpOpF64(const IROp op) {
+static Bool ref_isCmpOpF64(const IROp op) {
   switch (op) {
   case Iop_CmpF64:
     return True;
@@ -327,7 +902,7 @@ Bool vc_isCmpOpF64(const IROp op) {
 }
 
 /* Ternary */
-Bool vc_isTernaryOpF64(const IROp op) {
+static Bool ref_isTernaryOpF64(const IROp op) {
   switch (op) {
   case Iop_MAddF64:
   case Iop_MSubF64:
@@ -340,7 +915,7 @@ Bool vc_isTernaryOpF64(const IROp op) {
 }
 
 /* Intrinsics */
-Bool vc_isScalarIntrinsicOpF64(const IROp op) {
+static Bool ref_isScalarIntrinsicOpF64(const IROp op) {
   switch (op) {
   case Iop_SqrtF64:
   case Iop_AtanF64:       /* FPATAN,  arctan(arg1/arg2)       */
@@ -366,7 +941,7 @@ Bool vc_isScalarIntrinsicOpF64(const IROp op) {
 /* Lowest-Lane-Only */
 
 /* Binary */
-Bool vc_isLLOx2BinaryOpF64(const IROp op) {
+static Bool ref_isLLOx2BinaryOpF64(const IROp op) {
   switch (op) {
   case Iop_Add64F0x2:
   case Iop_Sub64F0x2:
@@ -379,7 +954,7 @@ Bool vc_isLLOx2BinaryOpF64(const IROp op) {
 }
 
 /* Comparisons */
-Bool vc_isLLOx2CompOpF64(const IROp op) {
+static Bool ref_isLLOx2CompOpF64(const IROp op) {
   switch (op) {
   case Iop_CmpEQ64F0x2:
   case Iop_CmpLT64F0x2:
@@ -392,7 +967,7 @@ Bool vc_isLLOx2CompOpF64(const IROp op) {
 }
 
 /* Intrinsics */
-Bool vc_isLLOx2IntrinsicOpF64(const IROp op) {
+static Bool ref_isLLOx2IntrinsicOpF64(const IROp op) {
   switch (op) {
   case Iop_Sqrt64F0x2:
     return True;
@@ -406,7 +981,7 @@ Bool vc_isLLOx2IntrinsicOpF64(const IROp op) {
 /* 2x */
 
 /* Unary */
-Bool vc_isVectorx2UnaryOpF64(const IROp op) {
+static Bool ref_isVectorx2UnaryOpF64(const IROp op) {
   switch (op) {
   case Iop_Neg64Fx2:
   case Iop_Abs64Fx2:
@@ -417,7 +992,7 @@ Bool vc_isVectorx2UnaryOpF64(const IROp op) {
 }
 
 /* Binary */
-Bool vc_isVectorx2BinaryOpF64(const IROp op) {
+static Bool ref_isVectorx2BinaryOpF64(const IROp op) {
   switch (op) {
   case Iop_Add64Fx2:
   case Iop_Sub64Fx2:
@@ -434,7 +1009,7 @@ Bool vc_isVectorx2BinaryOpF64(const IROp op) {
 }
 
 /* Comparisons */
-Bool vc_isVectorx2CompOpF64(const IROp op) {
+static Bool ref_isVectorx2CompOpF64(const IROp op) {
   switch (op) {
   case Iop_CmpEQ64Fx2:
   case Iop_CmpLT64Fx2:
@@ -451,7 +1026,7 @@ Bool vc_isVectorx2CompOpF64(const IROp op) {
 }
 
 /* Intrinsics */
-Bool vc_isVectorx2IntrinsicOpF64(const IROp op) {
+static Bool ref_isVectorx2IntrinsicOpF64(const IROp op) {
   switch (op) {
   case Iop_Sqrt64Fx2:
   case Iop_Scale2_64Fx2:
@@ -472,7 +1047,7 @@ Bool vc_isVectorx2IntrinsicOpF64(const IROp op) {
 /* Unary */
 
 /* Binary */
-Bool vc_isVectorx4BinaryOpF64(const IROp op) {
+static Bool ref_isVectorx4BinaryOpF64(const IROp op) {
   switch (op) {
   case Iop_Add64Fx4:
   case Iop_Sub64Fx4:
@@ -485,7 +1060,7 @@ Bool vc_isVectorx4BinaryOpF64(const IROp op) {
 }
 
 /* Intrinsics */
-Bool vc_isVectorx4IntrinsicOpF64(const IROp op) {
+static Bool ref_isVectorx4IntrinsicOpF64(const IROp op) {
   switch (op) {
   case Iop_Sqrt64Fx4:
     return True;
@@ -500,72 +1075,72 @@ Bool vc_isVectorx4IntrinsicOpF64(const IROp op) {
 
 /* Arithmetics op tests funtions */
 
-Bool vc_isScalarArithmeticOpF32(const IROp op) {
-  if (vc_isScalarUnaryOpF32(op)) {
+static Bool ref_isScalarArithmeticOpF32(const IROp op) {
+  if (ref_isScalarUnaryOpF32(op)) {
     return True;
-  } else if (vc_isScalarBinaryOpF32(op)) {
+  } else if (ref_isScalarBinaryOpF32(op)) {
     return True;
-  } else if (vc_isTernaryOpF32(op)) {
+  } else if (ref_isTernaryOpF32(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isVectorx2ArithmeticOpF32(const IROp op) {
-  if (vc_isVectorx2UnaryOpF32(op)) {
+static Bool ref_isVectorx2ArithmeticOpF32(const IROp op) {
+  if (ref_isVectorx2UnaryOpF32(op)) {
     return True;
-  } else if (vc_isVectorx2BinaryOpF32(op)) {
+  } else if (ref_isVectorx2BinaryOpF32(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isVectorx4ArithmeticOpF32(const IROp op) {
-  if (vc_isVectorx4UnaryOpF32(op)) {
+static Bool ref_isVectorx4ArithmeticOpF32(const IROp op) {
+  if (ref_isVectorx4UnaryOpF32(op)) {
     return True;
-  } else if (vc_isVectorx4BinaryOpF32(op)) {
+  } else if (ref_isVectorx4BinaryOpF32(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isVectorx8ArithmeticOpF32(const IROp op) {
-  if (vc_isVectorx4BinaryOpF32(op)) {
+static Bool ref_isVectorx8ArithmeticOpF32(const IROp op) {
+  if (ref_isVectorx8BinaryOpF32(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isLLOArithmeticOpF32(const IROp op) {
-  if (vc_isLLOx4BinaryOpF32(op)) {
+static Bool ref_isLLOArithmeticOpF32(const IROp op) {
+  if (ref_isLLOx4BinaryOpF32(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isVectorArithmeticOpF32(const IROp op) {
-  if (vc_isVectorx2ArithmeticOpF32(op)) {
+static Bool ref_isVectorArithmeticOpF32(const IROp op) {
+  if (ref_isVectorx2ArithmeticOpF32(op)) {
     return True;
-  } else if (vc_isVectorx2ArithmeticOpF32(op)) {
+  } else if (ref_isVectorx2ArithmeticOpF32(op)) {
     return True;
-  } else if (vc_isVectorx4ArithmeticOpF32(op)) {
+  } else if (ref_isVectorx4ArithmeticOpF32(op)) {
     return True;
-  } else if (vc_isVectorx8ArithmeticOpF32(op)) {
+  } else if (ref_isVectorx8ArithmeticOpF32(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isArithmeticOpF32(const IROp op) {
-  if (vc_isScalarArithmeticOpF32(op)) {
+static Bool ref_isArithmeticOpF32(const IROp op) {
+  if (ref_isScalarArithmeticOpF32(op)) {
     return True;
-  } else if (vc_isVectorArithmeticOpF32(op)) {
+  } else if (ref_isVectorArithmeticOpF32(op)) {
     return True;
   } else {
     return False;
@@ -576,68 +1151,68 @@ Bool vc_isArithmeticOpF32(const IROp op) {
 
 /* Arithmetics op tests funtions */
 
-Bool vc_isScalarArithmeticOpF64(const IROp op) {
-  if (vc_isScalarUnaryOpF64(op)) {
+static Bool ref_isScalarArithmeticOpF64(const IROp op) {
+  if (ref_isScalarUnaryOpF64(op)) {
     return True;
-  } else if (vc_isScalarBinaryOpF64(op)) {
+  } else if (ref_isScalarBinaryOpF64(op)) {
     return True;
-  } else if (vc_isTernaryOpF64(op)) {
+  } else if (ref_isTernaryOpF64(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isVectorx2ArithmeticOpF64(const IROp op) {
-  if (vc_isVectorx2UnaryOpF64(op)) {
+static Bool ref_isVectorx2ArithmeticOpF64(const IROp op) {
+  if (ref_isVectorx2UnaryOpF64(op)) {
     return True;
-  } else if (vc_isVectorx2BinaryOpF64(op)) {
+  } else if (ref_isVectorx2BinaryOpF64(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isVectorx4ArithmeticOpF64(const IROp op) {
-  if (vc_isVectorx4BinaryOpF64(op)) {
+static Bool ref_isVectorx4ArithmeticOpF64(const IROp op) {
+  if (ref_isVectorx4BinaryOpF64(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isVectorArithmeticOpF64(const IROp op) {
-  if (vc_isVectorx2ArithmeticOpF64(op)) {
+static Bool ref_isVectorArithmeticOpF64(const IROp op) {
+  if (ref_isVectorx2ArithmeticOpF64(op)) {
     return True;
-  } else if (vc_isVectorx4ArithmeticOpF64(op)) {
+  } else if (ref_isVectorx4ArithmeticOpF64(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isLLOArithmeticOpF64(const IROp op) {
-  if (vc_isLLOx2BinaryOpF64(op)) {
+static Bool ref_isLLOArithmeticOpF64(const IROp op) {
+  if (ref_isLLOx2BinaryOpF64(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isArithmeticOpF64(const IROp op) {
-  if (vc_isScalarArithmeticOpF64(op)) {
+static Bool ref_isArithmeticOpF64(const IROp op) {
+  if (ref_isScalarArithmeticOpF64(op)) {
     return True;
-  } else if (vc_isVectorArithmeticOpF64(op)) {
+  } else if (ref_isVectorArithmeticOpF64(op)) {
     return True;
   } else {
     return False;
   }
 }
 
-Bool vc_isArithmeticOpF(const IROp op) {
-  if (vc_isArithmeticOpF32(op)) {
+static Bool ref_isArithmeticOpF(const IROp op) {
+  if (ref_isArithmeticOpF32(op)) {
     return True;
-  } else if (vc_isArithmeticOpF64(op)) {
+  } else if (ref_isArithmeticOpF64(op)) {
     return True;
   } else {
     return False;
@@ -646,7 +1221,7 @@ Bool vc_isArithmeticOpF(const IROp op) {
 
 /* Type operators */
 
-Bool vc_isAddOp(const IROp op) {
+static Bool ref_isAddOp(const IROp op) {
   switch (op) {
   case Iop_AddF32:
   case Iop_Add32Fx2:
@@ -664,7 +1239,7 @@ Bool vc_isAddOp(const IROp op) {
   }
 }
 
-Bool vc_isSubOp(const IROp op) {
+static Bool ref_isSubOp(const IROp op) {
   switch (op) {
   case Iop_SubF32:
   case Iop_Sub32Fx2:
@@ -682,7 +1257,7 @@ Bool vc_isSubOp(const IROp op) {
   }
 }
 
-Bool vc_isMulOp(const IROp op) {
+static Bool ref_isMulOp(const IROp op) {
   switch (op) {
   case Iop_MulF32:
   case Iop_Mul32Fx2:
@@ -700,7 +1275,7 @@ Bool vc_isMulOp(const IROp op) {
   }
 }
 
-Bool vc_isDivOp(const IROp op) {
+static Bool ref_isDivOp(const IROp op) {
   switch (op) {
   case Iop_DivF32:
   case Iop_Div32Fx4:
@@ -717,7 +1292,7 @@ Bool vc_isDivOp(const IROp op) {
   }
 }
 
-Bool vc_isFmaOp(const IROp op) {
+static Bool ref_isFmaOp(const IROp op) {
   switch (op) {
   case Iop_MAddF32:
   case Iop_MSubF32:
@@ -732,325 +1307,118 @@ Bool vc_isFmaOp(const IROp op) {
 }
 
 /* Return the size of the operands */
-ULong vc_getSizeArithmeticOp(const IROp op) {
-  if (vc_isScalarArithmeticOpF32(op) || vc_isScalarArithmeticOpF64(op)
-      || vc_isLLOArithmeticOpF32(op) || vc_isLLOArithmeticOpF64(op)) {
+static ULong ref_getSizeArithmeticOp(const IROp op) {
+  if (ref_isScalarArithmeticOpF32(op) || ref_isScalarArithmeticOpF64(op)
+      || ref_isLLOArithmeticOpF32(op) || ref_isLLOArithmeticOpF64(op)) {
     return 1;
-  } else if (vc_isVectorx2ArithmeticOpF32(op) || vc_isVectorx2ArithmeticOpF64(op)) {
+  } else if (ref_isVectorx2ArithmeticOpF32(op) || ref_isVectorx2ArithmeticOpF64(op)) {
     return 2;
-  } else if (vc_isVectorx4ArithmeticOpF32(op) || vc_isVectorx4ArithmeticOpF64(op)) {
+  } else if (ref_isVectorx4ArithmeticOpF32(op) || ref_isVectorx4ArithmeticOpF64(op)) {
     return 4;
-  } else if (vc_isVectorx8ArithmeticOpF32(op)) {
+  } else if (ref_isVectorx8ArithmeticOpF32(op)) {
     return 8;
   } else {
     VG_(tool_panic)("Unknown arithmetic operator size");
   }
 }
 
-/* Name functions */
-
-const HChar *vc_getTypeNameOp(const IROp op) {
-  if (vc_isArithmeticOpF32(op)) {
-    return "b32";
-  } else if (vc_isArithmeticOpF64(op)) {
-    return "b64";
-  } else {
-    VG_(umsg)("Unkonw type name %u",op);
-    return "ukn";
-  }
-}
+/*--------------------------------------------------------------------*/
+/*--- Self-check                                                   ---*/
+/*--------------------------------------------------------------------*/
 
-const HChar *vc_getDimTypeNameOp(const IROp op) {
-  if (vc_isScalarArithmeticOpF32(op) ||
-      vc_isScalarArithmeticOpF64(op)) {
-    return "x1";
-  } else if (vc_isVectorx2ArithmeticOpF32(op) ||
-	     vc_isVectorx2ArithmeticOpF64(op)) {
-    return "x2";
-  } else if (vc_isVectorx4ArithmeticOpF32(op) ||
-	     vc_isVectorx4ArithmeticOpF64(op)) {
-    return "x4";
-  } else if (vc_isVectorx8ArithmeticOpF32(op)) {
-    return "x8";
-  } else {
-    VG_(umsg)("Unkonw operation dimension %u",op);
-    return "ukn";
+typedef Bool (*OpPredicate)(const IROp op);
+
+typedef struct _OpPredicateCheck OpPredicateCheck;
+struct _OpPredicateCheck {
+  const HChar *name;
+  OpPredicate table;
+  OpPredicate reference;
+};
+
+#define CHECK(p) { #p, vc_##p, ref_##p }
+
+static const OpPredicateCheck opPredicateChecks[] = {
+  CHECK(isScalarUnaryOpF32),
+  CHECK(isScalarBinaryOpF32),
+  CHECK(isCmpOpF32),
+  CHECK(isTernaryOpF32),
+  CHECK(isScalarIntrinsicOpF32),
+  CHECK(isLLOx4BinaryOpF32),
+  CHECK(isLLOx4CmpOpF32),
+  CHECK(isLLOx4IntrinsicOpF32),
+  CHECK(isVectorx2UnaryOpF32),
+  CHECK(isVectorx2BinaryOpF32),
+  CHECK(isVectorx2CmpOpF32),
+  CHECK(isVectorx2IntrinsicOpF32),
+  CHECK(isVectorx4UnaryOpF32),
+  CHECK(isVectorx4BinaryOpF32),
+  CHECK(isVectorx4CmpOpF32),
+  CHECK(isVectorx4IntrinsicOpF32),
+  CHECK(isVectorx8BinaryOpF32),
+  CHECK(isVectorx8IntrinsicOpF32),
+  CHECK(isScalarUnaryOpF64),
+  CHECK(isScalarBinaryOpF64),
+  CHECK(isCmpOpF64),
+  CHECK(isTernaryOpF64),
+  CHECK(isScalarIntrinsicOpF64),
+  CHECK(isLLOx2BinaryOpF64),
+  CHECK(isLLOx2CompOpF64),
+  CHECK(isLLOx2IntrinsicOpF64),
+  CHECK(isVectorx2UnaryOpF64),
+  CHECK(isVectorx2BinaryOpF64),
+  CHECK(isVectorx2CompOpF64),
+  CHECK(isVectorx2IntrinsicOpF64),
+  CHECK(isVectorx4BinaryOpF64),
+  CHECK(isVectorx4IntrinsicOpF64),
+  CHECK(isScalarArithmeticOpF32),
+  CHECK(isVectorx2ArithmeticOpF32),
+  CHECK(isVectorx4ArithmeticOpF32),
+  CHECK(isVectorx8ArithmeticOpF32),
+  CHECK(isLLOArithmeticOpF32),
+  CHECK(isVectorArithmeticOpF32),
+  CHECK(isArithmeticOpF32),
+  CHECK(isScalarArithmeticOpF64),
+  CHECK(isVectorx2ArithmeticOpF64),
+  CHECK(isVectorx4ArithmeticOpF64),
+  CHECK(isVectorArithmeticOpF64),
+  CHECK(isLLOArithmeticOpF64),
+  CHECK(isArithmeticOpF64),
+  CHECK(isArithmeticOpF),
+  CHECK(isAddOp),
+  CHECK(isSubOp),
+  CHECK(isMulOp),
+  CHECK(isDivOp),
+  CHECK(isFmaOp),
+};
+
+#undef CHECK
+
+void vc_checkOpTable(void) {
+  UInt i, j;
+  IROp op;
+  UInt nbErrors = 0;
+
+  for (i = 1; i < NB_OPS; i++) {
+    op = Iop_INVALID + i;
+    for (j = 0; j < SIZE_ARRAY(opPredicateChecks); j++) {
+      const OpPredicateCheck *check = &opPredicateChecks[j];
+      if (check->table(op) != check->reference(op)) {
+	VG_(umsg)("Op table mismatch: %s(%s) = %d, expected %d\n",
+		  check->name, vc_getOpDesc(op)->name,
+		  check->table(op), check->reference(op));
+	nbErrors++;
+      }
+    }
+    if (ref_isArithmeticOpF(op)
+	&& vc_getSizeArithmeticOp(op) != ref_getSizeArithmeticOp(op)) {
+      VG_(umsg)("Op table mismatch: getSizeArithmeticOp(%s) = %llu, expected %llu\n",
+		vc_getOpDesc(op)->name,
+		vc_getSizeArithmeticOp(op), ref_getSizeArithmeticOp(op));
+      nbErrors++;
+    }
   }
-}
-
-const HChar *vc_getArithmeticNameOp(const IROp op) {
-  if (vc_isAddOp(op)) {
-    return "add";
-  } else if (vc_isSubOp(op)) {
-    return "sub";
-  } else if (vc_isMulOp(op)) {
-    return "mul";
-  } else if (vc_isDivOp(op)) {
-    return "div";
-  } else if (vc_isFmaOp(op)) {
-    return "fma";
-  } else {
-    VG_(umsg)("Unknown operation type %u",op);
-    return "unk";
-  }
-}
-
-void vc_getNameOp(const IROp op, HChar *name) {
-  const HChar *type = vc_getTypeNameOp(op);
-  const HChar *dim = vc_getDimTypeNameOp(op);
-  const HChar *sym = vc_getArithmeticNameOp(op);
-  VG_(strcat)(name, type);
-  VG_(strcat)(name, sym);
-  VG_(strcat)(name, dim);
-}
 
-const HChar* vc_getRawNameOp(const IROp op) {
-  switch (op) {
-  case Iop_NegF32:
-    return "NegF32";
-  case Iop_AbsF32:
-    return "AbsF32";
-  case Iop_AddF32:
-    return "AddF32";
-  case Iop_SubF32:
-    return "SubF32";
-  case Iop_MulF32:
-    return "MulF32";
-  case Iop_DivF32:
-    return "DivF32";
-  case Iop_CmpF32:
-    return "CmpF32";
-  case Iop_MAddF32:
-    return "MAddF32";
-  case Iop_MSubF32:
-    return "MSubF32";
-  case Iop_SqrtF32:
-    return "SqrtF32";
-  case Iop_RecpExpF32:
-    return "RecpExpF32";
-  case Iop_Neg32Fx2:
-    return "Neg32Fx2";
-  case Iop_Abs32Fx2:
-    return "Abs32Fx2";
-  case Iop_Add32Fx2:
-    return "Add32Fx2";
-  case Iop_Sub32Fx2:
-    return "Sub32Fx2";
-  case Iop_Mul32Fx2:
-    return "Mul32Fx2";
-  case Iop_CmpEQ32Fx2:
-    return "CmpEQ32Fx2";
-  case Iop_CmpGT32Fx2:
-    return "CmpGT32Fx2";
-  case Iop_CmpGE32Fx2:
-    return "CmpGE32Fx2";
-  case Iop_RecipEst32Fx2:
-    return "RecipEst32Fx2";
-  case Iop_RecipStep32Fx2:
-    return "RecipStep32Fx2";
-  case Iop_RSqrtEst32Fx2:
-    return "RSqrtEst32Fx2";
-  case Iop_RSqrtStep32Fx2:
-    return "RSqrtStep32Fx2";
-  case Iop_Neg32Fx4:
-    return "Neg32Fx4";
-  case Iop_Abs32Fx4:
-    return "Abs32Fx4";
-  case Iop_Add32Fx4:
-    return "Add32Fx4";
-  case Iop_Sub32Fx4:
-    return "Sub32Fx4";
-  case Iop_Mul32Fx4:
-    return "Mul32Fx4";
-  case Iop_Div32Fx4:
-    return "Div32Fx4";
-  case Iop_Add32F0x4:
-    return "Add32F0x4";
-  case Iop_Sub32F0x4:
-    return "Sub32F0x4";
-  case Iop_Mul32F0x4:
-    return "Mul32F0x4";
-  case Iop_Div32F0x4:
-    return "Div32F0x4";
-  case Iop_CmpEQ32Fx4:
-    return "CmpEQ32Fx4";
-  case Iop_CmpLT32Fx4:
-    return "CmpLT32Fx4";
-  case Iop_CmpLE32Fx4:
-    return "CmpLE32Fx4";
-  case Iop_CmpUN32Fx4:
-    return "CmpUN32Fx4";
-  case Iop_CmpGT32Fx4:
-    return "CmpGT32Fx4";
-  case Iop_CmpGE32Fx4:
-    return "CmpGE32Fx4";
-  case Iop_CmpEQ32F0x4:
-    return "CmpEQ32Fx4";
-  case Iop_CmpLT32F0x4:
-    return "CmpLT32F0x4";
-  case Iop_CmpLE32F0x4:
-    return "CmpLE32Fx4";
-  case Iop_CmpUN32F0x4:
-    return "CmpUN32F0x4";
-  case Iop_Sqrt32Fx4:
-    return "Sqrt32Fx4";
-  case Iop_RecipEst32Fx4:
-    return "RecipEst32Fx4";
-  case Iop_RecipStep32Fx4:
-    return "RecipStep32Fx4";
-  case Iop_Scale2_32Fx4:
-    return "Scale2_32Fx4";
-  case Iop_Log2_32Fx4:
-    return "Log2_32Fx4";
-  case Iop_Exp2_32Fx4:
-    return "Exp2_32Fx4";
-  case Iop_RSqrtStep32Fx4:
-    return "RSqrtStep32Fx4";
-  case Iop_RecipEst32F0x4:
-    return "RecipEst32F0x4";
-  case Iop_Sqrt32F0x4:
-    return "Sqrt32F0x4";
-  case Iop_RSqrtEst32F0x4:
-    return "RSqrtEst32F0x4";
-  case Iop_Add32Fx8:
-    return "Add32Fx8";
-  case Iop_Sub32Fx8:
-    return "Sub32Fx8";
-  case Iop_Mul32Fx8:
-    return "Mul32Fx8";
-  case Iop_Div32Fx8:
-    return "Div32Fx8";
-  case Iop_Sqrt32Fx8:
-    return "Sqrt32Fx8";
-  case Iop_RSqrtEst32Fx8:
-    return "RSqrtEst32Fx8";
-  case Iop_RecipEst32Fx8:
-    return "RecipEst32Fx8";
-  case Iop_NegF64:
-    return "NegF64";
-  case Iop_AbsF64:
-    return "AbsF64";
-  case Iop_AddF64:
-    return "AddF64";
-  case Iop_SubF64:
-    return "SubF64";
-  case Iop_MulF64:
-    return "MulF64";
-  case Iop_DivF64:
-    return "DivF64";
-  case Iop_AddF64r32:
-    return "AddF64r32";
-  case Iop_SubF64r32:
-    return "SubF64r32";
-  case Iop_MulF64r32:
-    return "MulF64r32";
-  case Iop_DivF64r32:
-    return "DivF64r32";
-  case Iop_CmpF64:
-    return "CmpF64";
-  case Iop_MAddF64:
-    return "MAddF64";
-  case Iop_MSubF64:
-    return "MSubF64";
-  case Iop_MAddF64r32:
-    return "MAddF64r32";
-  case Iop_MSubF64r32:
-    return "MSubF64r32";
-  case Iop_SqrtF64:
-    return "SqrtF64";
-  case Iop_AtanF64:
-    return "AtanF64";
-  case Iop_Yl2xF64:
-    return "Yl2xF64";
-  case Iop_Yl2xp1F64:
-    return "Yl2xp1F64";
-  case Iop_PRemF64:
-    return "PRemF64";
-  case Iop_PRemC3210F64:
-    return "PRemC3210F64";
-  case Iop_PRem1F64:
-    return "PRem1F64";
-  case Iop_PRem1C3210F64:
-    return "PRem1C3210F64";
-  case Iop_ScaleF64:
-    return "ScaleF64";
-  case Iop_SinF64:
-    return "SinF64";
-  case Iop_CosF64:
-    return "CosF64";
-  case Iop_TanF64:
-    return "TanF64";
-  case Iop_2xm1F64:
-    return "2xm1F64";
-  case Iop_RSqrtEst5GoodF64:
-    return "RSqrtEst5GoodF64";
-  case Iop_RecpExpF64:
-    return "RecpExpF64";
-  case Iop_Neg64Fx2:
-    return "Neg64Fx2";
-  case Iop_Abs64Fx2:
-    return "Abs64Fx2";
-  case Iop_Add64Fx2:
-    return "Add64Fx2";
-  case Iop_Sub64Fx2:
-    return "Sub64Fx2";
-  case Iop_Mul64Fx2:
-    return "Mul64Fx2";
-  case Iop_Div64Fx2:
-    return "Div64Fx2";
-  case Iop_Add64F0x2:
-    return "Add64F0x2";
-  case Iop_Sub64F0x2:
-    return "Sub64F0x2";
-  case Iop_Mul64F0x2:
-    return "Mul64F0x2";
-  case Iop_Div64F0x2:
-    return "Div64F0x2";
-  case Iop_CmpEQ64Fx2:
-    return "CmpEQ64Fx2";
-  case Iop_CmpLT64Fx2:
-    return "CmpLT64Fx2";
-  case Iop_CmpLE64Fx2:
-    return "CmpLE64Fx2";
-  case Iop_CmpUN64Fx2:
-    return "CmpUN64Fx2";
-  case Iop_CmpEQ64F0x2:
-    return "CmpEQ64F0x2";
-  case Iop_CmpLT64F0x2:
-    return "CmpLT64F0x2";
-  case Iop_CmpLE64F0x2:
-    return "CmpLE64F0x2";
-  case Iop_CmpUN64F0x2:
-    return "CmpUN64F0x2";
-  case Iop_Sqrt64Fx2:
-    return "Sqrt64Fx2";
-  case Iop_Scale2_64Fx2:
-    return "Scale2_64Fx2";
-  case Iop_Log2_64Fx2:
-    return "Log2_64Fx2";
-  case Iop_RecipEst64Fx2:
-    return "RecipEst64Fx2";
-  case Iop_RecipStep64Fx2:
-    return "RecipStep64Fx2";
-  case Iop_RSqrtEst64Fx2:
-    return "RSqrtEst64Fx2";
-  case Iop_RSqrtStep64Fx2:
-    return "RSqrtStep64Fx2";
-  case Iop_Sqrt64F0x2:
-    return "Sqrt64F0x2";
-  case Iop_Add64Fx4:
-    return "Add64Fx4";
-  case Iop_Sub64Fx4:
-    return "Sub64Fx4";
-  case Iop_Mul64Fx4:
-    return "Mul64Fx4";
-  case Iop_Div64Fx4:
-    return "Div64Fx4";
-  case Iop_Sqrt64Fx4:
-    return "Sqrt64Fx4";
-  default:
-    
-    VG_(umsg)("Unknown op %u\n", op);
-    return "unk";
+  if (nbErrors > 0) {
+    VG_(tool_panic)("FP operations table does not match the reference predicates");
   }
 }
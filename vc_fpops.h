@@ -27,12 +27,65 @@
 */
 
 #ifndef __VC_FOPS_H__
-#define __VF_FOPS_H__
+#define __VC_FOPS_H__
 
 #include "libvex_ir.h"
 
 /* Arithmetic operations include {+,-,*,/} */
 
+/* FP operations are classified by a descriptor table indexed by IROp. */
+/* All the predicates below are answered from this table.              */
+
+/* Class of an operation */
+typedef enum _OpClass OpClass;
+enum _OpClass {
+	       OPCLASS_NONE = 0,
+	       OPCLASS_UNARY,
+	       OPCLASS_BINARY,
+	       OPCLASS_TERNARY,
+	       OPCLASS_CMP,
+	       OPCLASS_INTRINSIC
+};
+
+/* Arithmetic operation */
+typedef enum _OpArith OpArith;
+enum _OpArith {
+	       OPARITH_OTHER = 0,
+	       OPARITH_ADD,
+	       OPARITH_SUB,
+	       OPARITH_MUL,
+	       OPARITH_DIV,
+	       OPARITH_FMA
+};
+
+/* Descriptor of an operation                               */
+/* - opClass  : OpClass of the operation                    */
+/* - precision: 32 or 64, 0 if not an FP operation          */
+/* - lanes    : Number of elements of the vector register   */
+/* - llo      : True if Lowest-Lane-Only (only the first    */
+/*              lane is computed)                           */
+/* - arith    : OpArith of the operation                    */
+/* - flops    : Number of FLOPs per computed lane           */
+/* - name     : Name of the IROp without the Iop_ prefix    */
+typedef struct _OpDesc OpDesc;
+struct _OpDesc {
+  UChar opClass;
+  UChar precision;
+  UChar lanes;
+  Bool llo;
+  UChar arith;
+  UChar flops;
+  const HChar *name;
+};
+
+/* Returns the descriptor of op, with a NONE class if op is not */
+/* a known FP operation                                         */
+const OpDesc* vc_getOpDesc(const IROp op);
+
+/* Checks that the table gives the same answers than the switch-based */
+/* reference predicates. Panics on mismatch.                          */
+void vc_checkOpTable(void);
+
 /******************************************/
 /*                Binary32                */
 /******************************************/
@@ -214,10 +267,31 @@ Bool vc_isFmaOp(const IROp op);
 /* N for VectorxN */
 ULong vc_getSizeArithmeticOp(const IROp op);
 
+/* Returns the number of FLOPs of the operation */
+/* Size of the operands times the FLOPs per     */
+/* lane (2 for FMA, 0 for Neg and Abs, 1        */
+/* otherwise)                                   */
+ULong vc_getFlopsArithmeticOp(const IROp op);
+
 const HChar *vc_getTypeNameOp(const IROp op);
 const HChar *vc_getDimTypeNameOp(const IROp op);
 const HChar *vc_getArithmeticNameOp(const IROp op);
 void vc_getNameOp(const IROp op, HChar *name);
 const HChar *vc_getRawNameOp(const IROp op);
 
-#endif /* __VF_FOPS_H__ */
+/* Op-mix cells                                                 */
+/* Arithmetic ops are split by precision {b32,b64}, operation   */
+/* {add,sub,mul,div,fma,oth} and computed lanes {x1,x2,x4,x8}.  */
+/* Other operations (neg, abs, sqrt, ...) fall in the oth cells */
+#define OPMIX_NB_PRECISIONS 2
+#define OPMIX_NB_ARITHS 6
+#define OPMIX_NB_WIDTHS 4
+#define OPMIX_NB_CELLS (OPMIX_NB_PRECISIONS * OPMIX_NB_ARITHS * OPMIX_NB_WIDTHS)
+#define OPMIX_NAME_SIZE 16
+
+/* Returns the cell of an arithmetic op, in [0, OPMIX_NB_CELLS) */
+UInt vc_getOpMixCell(const IROp op);
+/* Writes the name of a cell, e.g. "b64divx4", in name */
+void vc_getOpMixCellName(const UInt cell, HChar *name);
+
+#endif /* __VC_FOPS_H__ */
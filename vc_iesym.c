@@ -38,25 +38,27 @@
 #include "pub_tool_libcassert.h"
 #include "pub_tool_libcbase.h"
 #include "pub_tool_seqmatch.h"
+#include "pub_tool_oset.h"
+#include "pub_tool_xarray.h"
+#include "pub_tool_vki.h"
+#include "pub_tool_libcfile.h"
 
 #include "vc_iesym.h"
 #include "vc_utils.h"
 #include "vc_debuginfo.h"
+#include "vc_match.h"
 
-static ULong nbIgnoredLibs = 0;
 static const HChar* ignoredLibsDefault[] = {"*/ld-*",
 					    "*/libc-*",
 					    "*libdl-*",
 					    "*/libmpfr.*"};
 
-static ULong nbIgnoredFunctions = 0;
 static const HChar* ignoredFunctionsDefault[] = {"???","__libc*","_start"};
 
 /* op = {add, sub, mul, div} */
 /* type = {float, double}    */
 /* _interflop_{op}_{type}    */
 static const HChar* interflopIncludedLibs[] = {"*/libinterflop_*"};
-static const SizeT nbInterflopIncludedLibs = SIZE_ARRAY(interflopIncludedLibs);
 
 static const HChar* interflopExcludedFiles[] = {"logger.c",
 					       "options.c",
@@ -64,8 +66,6 @@ static const HChar* interflopExcludedFiles[] = {"logger.c",
 						"printf_specifier.c",
 						"vprec_tools.c"};
 
-static const SizeT nbInterflopExcludedFiles = SIZE_ARRAY(interflopExcludedFiles);
- 
 static const HChar* interflopExcludedFunctions[] = {"*logger*",
 						    "_set_seed_default",
 						    "init_context",
@@ -89,97 +89,372 @@ static const HChar* interflopExcludedFunctions[] = {"*logger*",
 						    "_set_vprec_*",
 						    "_bitmask_binary*"};
 
-static const SizeT nbInterflopExcludedFunctions = SIZE_ARRAY(interflopExcludedFunctions);
-
 static const HChar* interflopIncludedFunctions[] = {"*_interflop_*"};
-static const SizeT nbInterflopIncludedFunctions = SIZE_ARRAY(interflopIncludedFunctions);
 
-static const HChar* interflopExcludedLibs[] = {"**"};
-static const SizeT nbInterflopExcludedLibs = SIZE_ARRAY(interflopIncludedLibs);
+/* The lists are compiled once at startup, matching a name costs */
+/* O(length of the name) whatever the number of patterns.        */
+/* The ignored lists and the only lists also receive the         */
+/* patterns given on the command line (see add_scope_pattern)    */
+static Matcher *ignoredLibs = NULL;
+static Matcher *ignoredFunctions = NULL;
+static Matcher *onlyLibs = NULL;
+static Matcher *onlyFunctions = NULL;
+static Matcher *interflopIncludedLibsM = NULL;
+static Matcher *interflopExcludedFilesM = NULL;
+static Matcher *interflopExcludedFunctionsM = NULL;
+static Matcher *interflopIncludedFunctionsM = NULL;
+
+static Matcher* getMatcher(Matcher **M, const HChar *name) {
+  if (*M == NULL) {
+    Matcher_Init(M, name);
+  }
+  return *M;
+}
 
+static void addPatterns(Matcher **M, const HChar *name,
+			const HChar **patterns, SizeT size) {
+  SizeT i;
+  getMatcher(M, name);
+  for (i = 0; i < size; i++) {
+    Matcher_Add(*M, patterns[i]);
+  }
+}
 
-static HChar** ignoredLibs = NULL;
-static HChar** ignoredFunctions = NULL;
+static Matcher* getScopeMatcher(ScopeList list) {
+  switch (list) {
+  case SCOPE_IGNORE_OBJ: return getMatcher(&ignoredLibs, "ignored libs");
+  case SCOPE_IGNORE_FN:  return getMatcher(&ignoredFunctions, "ignored functions");
+  case SCOPE_ONLY_OBJ:   return getMatcher(&onlyLibs, "only libs");
+  case SCOPE_ONLY_FN:    return getMatcher(&onlyFunctions, "only functions");
+  default:
+    VG_(tool_panic)("Unknown scope list");
+  }
+}
 
 void init_ignored_libs_default() {
-  Int i;
+  addPatterns(&ignoredLibs, "ignored libs", ignoredLibsDefault,
+	      SIZE_ARRAY(ignoredLibsDefault));
+  addPatterns(&ignoredFunctions, "ignored functions", ignoredFunctionsDefault,
+	      SIZE_ARRAY(ignoredFunctionsDefault));
+  addPatterns(&interflopIncludedLibsM, "interflop libs", interflopIncludedLibs,
+	      SIZE_ARRAY(interflopIncludedLibs));
+  addPatterns(&interflopExcludedFilesM, "interflop excluded files",
+	      interflopExcludedFiles, SIZE_ARRAY(interflopExcludedFiles));
+  addPatterns(&interflopExcludedFunctionsM, "interflop excluded functions",
+	      interflopExcludedFunctions, SIZE_ARRAY(interflopExcludedFunctions));
+  addPatterns(&interflopIncludedFunctionsM, "interflop functions",
+	      interflopIncludedFunctions, SIZE_ARRAY(interflopIncludedFunctions));
+  getScopeMatcher(SCOPE_ONLY_OBJ);
+  getScopeMatcher(SCOPE_ONLY_FN);
+}
+
+void free_ignored_libs(void) {
+  Matcher_Free(&ignoredLibs);
+  Matcher_Free(&ignoredFunctions);
+  Matcher_Free(&onlyLibs);
+  Matcher_Free(&onlyFunctions);
+  Matcher_Free(&interflopIncludedLibsM);
+  Matcher_Free(&interflopExcludedFilesM);
+  Matcher_Free(&interflopExcludedFunctionsM);
+  Matcher_Free(&interflopIncludedFunctionsM);
+}
+
+void add_scope_pattern(ScopeList list, const HChar *pattern) {
+  Matcher_Add(getScopeMatcher(list), pattern);
+}
 
-  nbIgnoredLibs = sizeof(ignoredLibsDefault)/sizeof(HChar*);
-  ignoredLibs = (HChar**)VG_(malloc)("init.ign.libs", nbIgnoredLibs*sizeof(HChar*));
-  for (i = 0; i < nbIgnoredLibs; i++) {
-    ignoredLibs[i] = (HChar*)VG_(malloc)("init.ign.libs.str",sizeof(HChar));
-    VG_(strcpy)(ignoredLibs[i], ignoredLibsDefault[i]);
+/*--------------------------------------------------------------------*/
+/*--- Scope files                                                  ---*/
+/*--------------------------------------------------------------------*/
+
+#define SCOPE_FILE_CHUNK 4096
+
+typedef struct _ScopeKeyword ScopeKeyword;
+struct _ScopeKeyword {
+  const HChar *keyword;
+  ScopeList list;
+};
+
+static const ScopeKeyword scopeKeywords[] = {
+  {"ignore-obj", SCOPE_IGNORE_OBJ},
+  {"ignore-fn",  SCOPE_IGNORE_FN},
+  {"only-obj",   SCOPE_ONLY_OBJ},
+  {"only-fn",    SCOPE_ONLY_FN}
+};
+
+/* Parses a line "<keyword> <pattern>" of a scope file            */
+/* Leading and trailing blanks are dropped, empty lines and lines */
+/* starting with '#' are skipped. The line is modified in place   */
+static Bool parseScopeLine(HChar *line) {
+  SizeT i;
+  HChar *end;
+
+  while (VG_(isspace)(*line)) {
+    line++;
   }
-  
-  nbIgnoredFunctions = sizeof(ignoredFunctionsDefault)/sizeof(HChar*);
-  ignoredFunctions = (HChar**)VG_(malloc)("init.ign.fun", nbIgnoredFunctions*sizeof(HChar*));
-  for (i = 0; i < nbIgnoredFunctions; i++) {
-    ignoredFunctions[i] = (HChar*)VG_(malloc)("init.ign.fun.str",sizeof(HChar));
-    VG_(strcpy)(ignoredFunctions[i], ignoredFunctionsDefault[i]);
+  if (*line == '\0' || *line == '#') {
+    return True;
+  }
+  end = line + VG_(strlen)(line);
+  while (end > line && VG_(isspace)(end[-1])) {
+    *--end = '\0';
   }
 
-  
+  HChar *pattern = line;
+  while (*pattern && !VG_(isspace)(*pattern)) {
+    pattern++;
+  }
+  if (*pattern == '\0') {
+    return False;
+  }
+  *pattern++ = '\0';
+  while (VG_(isspace)(*pattern)) {
+    pattern++;
+  }
+
+  for (i = 0; i < SIZE_ARRAY(scopeKeywords); i++) {
+    if (VG_(strcmp)(line, scopeKeywords[i].keyword) == 0) {
+      add_scope_pattern(scopeKeywords[i].list, pattern);
+      return True;
+    }
+  }
+  return False;
 }
 
-Bool isStrInList(HChar **libList, const SizeT size, const HChar *lib, const HChar *dmsg);
-Bool isStrInList(HChar **libList, const SizeT size, const HChar *lib, const HChar *dmsg) {
-  Int i;
-  Bool isIn = False;  
-  for (i = 0; i < size; i++) {
-    isIn |= VG_(string_match)(libList[i], lib); 
-    if (dmsg) {
-      VG_(dmsg)("(%s) [%s] %s in %s\n", dmsg,
-		(VG_(string_match)(libList[i], lib)) ? "found" : "not found",
-		libList[i], lib);
+Bool load_scope_file(const HChar *path) {
+  Int n;
+  SizeT size = 0, capacity = SCOPE_FILE_CHUNK;
+  UInt lineNo = 1;
+
+  SysRes sres = VG_(open)(path, VKI_O_RDONLY, 0);
+  if (sr_isError(sres)) {
+    VG_(fmsg)("cannot open scope file '%s'\n", path);
+    return False;
+  }
+  const Int fd = sr_Res(sres);
+
+  /* Reads the whole file, terminated by '\0' */
+  HChar *buf = VG_(malloc)("scope.file", capacity + 1);
+  while ((n = VG_(read)(fd, buf + size, capacity - size)) > 0) {
+    size += n;
+    if (size == capacity) {
+      capacity *= 2;
+      buf = VG_(realloc)("scope.file", buf, capacity + 1);
+    }
+  }
+  VG_(close)(fd);
+  buf[size] = '\0';
+
+  Bool ok = True;
+  HChar *line = buf;
+  while (ok && *line) {
+    HChar *eol = VG_(strchr)(line, '\n');
+    if (eol) {
+      *eol = '\0';
     }
- }
-  return isIn;
+    if (!parseScopeLine(line)) {
+      VG_(fmsg)("%s:%u: expected '<ignore-obj|ignore-fn|only-obj|only-fn> <pattern>'\n",
+		path, lineNo);
+      ok = False;
+    }
+    line = (eol) ? eol + 1 : line + VG_(strlen)(line);
+    lineNo++;
+  }
+  VG_(free)(buf);
+  return ok;
 }
 
-InstType get_InstType(const DebugInfo *di) {
+/*--------------------------------------------------------------------*/
+/*--- Object verdicts                                              ---*/
+/*--------------------------------------------------------------------*/
+
+/* The verdict of an object (library or binary) only depends on its */
+/* name. It is computed once per mapped object, recorded for the    */
+/* address range of its executable mapping and dropped on unmap.    */
+#define OBJ_VERDICT_IGNORED   0x1
+#define OBJ_VERDICT_INTERFLOP 0x2
+#define OBJ_VERDICT_OUTSIDE   0x4
+
+/* Executable mapping of an object                       */
+/* - start, end: Address range of the mapping            */
+/* - resolved  : True if the verdict has been computed.  */
+/*               The object name may not be known when   */
+/*               the mapping is created, it is then      */
+/*               resolved at the first lookup            */
+/* - verdict   : OBJ_VERDICT_* flags                     */
+typedef struct _ObjRange ObjRange;
+struct _ObjRange {
+  Addr start;
+  Addr end;
+  Bool resolved;
+  UChar verdict;
+};
+
+static OSet *objRanges = NULL;
+
+static Word cmpAddr_ObjRange(const void* key, const void* elem) {
+  const Addr a = *(const Addr*)key;
+  const ObjRange *range = (const ObjRange*)elem;
+  if (a < range->start) {
+    return -1;
+  } else if (a >= range->end) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+static UChar computeObjVerdict(const HChar *lib) {
+  UChar verdict = 0;
+  if (Matcher_Match(ignoredLibs, lib)) {
+    verdict |= OBJ_VERDICT_IGNORED;
+  }
+  if (Matcher_Match(interflopIncludedLibsM, lib)) {
+    verdict |= OBJ_VERDICT_INTERFLOP;
+  }
+  if (Matcher_Size(onlyLibs) > 0 && !Matcher_Match(onlyLibs, lib)) {
+    verdict |= OBJ_VERDICT_OUTSIDE;
+  }
+  return verdict;
+}
+
+void init_obj_verdicts(void) {
+  objRanges = VG_(OSetGen_Create)(offsetof(ObjRange, start),
+				  cmpAddr_ObjRange,
+				  VG_(malloc),
+				  "objverdict.init",
+				  VG_(free));
+}
+
+void remove_obj_verdicts(Addr a, SizeT len) {
+  ObjRange *range;
+  Word i;
+
+  if (objRanges == NULL || len == 0) {
+    return;
+  }
+
+  /* The set cannot be modified while iterating */
+  XArray *dropped = VG_(newXA)(VG_(malloc), "objverdict.remove",
+			       VG_(free), sizeof(Addr));
+  VG_(OSetGen_ResetIter)(objRanges);
+  while ( (range = VG_(OSetGen_Next)(objRanges)) ) {
+    if (range->start < a + len && a < range->end) {
+      VG_(addToXA)(dropped, &range->start);
+    }
+  }
+  for (i = 0; i < VG_(sizeXA)(dropped); i++) {
+    range = VG_(OSetGen_Remove)(objRanges, VG_(indexXA)(dropped, i));
+    VG_(OSetGen_FreeNode)(objRanges, range);
+  }
+  VG_(deleteXA)(dropped);
+}
+
+void add_obj_verdict(Addr a, SizeT len) {
+  const HChar *lib;
+
+  if (objRanges == NULL || len == 0) {
+    return;
+  }
+
+  /* A new mapping replaces the previous ones */
+  remove_obj_verdicts(a, len);
+
+  ObjRange *range = VG_(OSetGen_AllocNode)(objRanges, sizeof(ObjRange));
+  range->start = a;
+  range->end = a + len;
+  range->resolved = VG_(get_objname)(VG_(current_DiEpoch)(), a, &lib);
+  range->verdict = (range->resolved) ? computeObjVerdict(lib) : 0;
+  VG_(OSetGen_Insert)(objRanges, range);
+}
+
+/* Returns the verdict of the object of di */
+static UChar get_obj_verdict(const DebugInfo *di) {
+  ObjRange *range = NULL;
+  if (objRanges) {
+    range = VG_(OSetGen_Lookup)(objRanges, &di->entry);
+  }
+  if (range == NULL) {
+    /* Not an executable mapping seen by the tool (e.g. vdso) */
+    return computeObjVerdict(di->lib);
+  }
+  if (!range->resolved) {
+    range->verdict = computeObjVerdict(di->lib);
+    range->resolved = True;
+  }
+  return range->verdict;
+}
+
+/*--------------------------------------------------------------------*/
+/*--- Symbol verdicts                                              ---*/
+/*--------------------------------------------------------------------*/
+
+/* The verdict of a symbol depends on its names and on whether it is */
+/* queried at its entry. Both verdicts are cached in an array indexed */
+/* by the symbol ID (see vc_debuginfo.h), which is dense and stable.  */
+#define INIT_SIZE_SYM_VERDICTS 4096
+#define SYM_VERDICT_UNKNOWN 0xFF
+
+typedef struct _SymVerdict SymVerdict;
+struct _SymVerdict {
+  UChar atEntry;
+  UChar inBody;
+};
+
+static SymVerdict *symVerdicts = NULL;
+static ULong symVerdictsCapacity = 0;
+
+static SymVerdict* get_sym_verdict(ULong symId) {
+  if (symId >= symVerdictsCapacity) {
+    ULong capacity = (symVerdictsCapacity) ? symVerdictsCapacity : INIT_SIZE_SYM_VERDICTS;
+    while (capacity <= symId) {
+      capacity *= 2;
+    }
+    symVerdicts = VG_(realloc)("symverdict.resize", symVerdicts,
+			       capacity * sizeof(SymVerdict));
+    VG_(memset)(symVerdicts + symVerdictsCapacity, SYM_VERDICT_UNKNOWN,
+		(capacity - symVerdictsCapacity) * sizeof(SymVerdict));
+    symVerdictsCapacity = capacity;
+  }
+  return &symVerdicts[symId];
+}
+
+static InstType compute_InstType(const DebugInfo *di) {
 
   if (VG_(strcmp)(di->function,"???") == 0) {
     return INST_IGNORE;
   }
   
+  const UChar objVerdict = get_obj_verdict(di);
+
   /* Check if the lib must be ignored */
-  Bool isIgnoredLib = isStrInList(ignoredLibs,
-				  nbIgnoredLibs,
-				  di->lib,
-				  NULL);
-  if (isIgnoredLib) {
+  if (objVerdict & OBJ_VERDICT_IGNORED) {
     return INST_IGNORE;
   }  
 
   /* Check if the function must be ignored */
-  Bool isIgnoredFunction = isStrInList(ignoredFunctions,
-				       nbIgnoredFunctions,
-				       di->function, NULL);
+  Bool isIgnoredFunction = Matcher_Match(ignoredFunctions, di->function);
   if (isIgnoredFunction) {
     return INST_IGNORE;
   }  
 
   /* Check that is not an excluded file of interflop */  
-  Bool isExcludedFile = isStrInList(interflopExcludedFiles,
-				    nbInterflopExcludedFiles,
-				    di->file, NULL);
+  Bool isExcludedFile = Matcher_Match(interflopExcludedFilesM, di->file);
   if (isExcludedFile) {
     return INST_IGNORE;
   }
 
   /* Check that is not an excluded function of interflop */  
-  Bool isInterflopExcludedFunction = isStrInList(interflopExcludedFunctions,
-						 nbInterflopExcludedFunctions,
-						 di->function, NULL);
+  Bool isInterflopExcludedFunction = Matcher_Match(interflopExcludedFunctionsM,
+						   di->function);
   if (isInterflopExcludedFunction) {
     return INST_IGNORE;
   }
     
 
   /* Check if the function belongs to interflop */
-  Bool isInterflopIncludedFunction = isStrInList(interflopIncludedFunctions,
-					 nbInterflopIncludedFunctions,
-					 di->function, NULL);
+  Bool isInterflopIncludedFunction = Matcher_Match(interflopIncludedFunctionsM,
+						   di->function);
   
   
   if (isInterflopIncludedFunction && di->isEntry) {
@@ -187,14 +462,103 @@ InstType get_InstType(const DebugInfo *di) {
   } 
 
   /* Check if the lib belongs to interflop */
-  Bool isInterflopIncludedLib = isStrInList(interflopIncludedLibs,
-  					    nbInterflopIncludedLibs,
-  					    di->lib, NULL);
-  if (isInterflopIncludedLib) {
+  if (objVerdict & OBJ_VERDICT_INTERFLOP) {
     return INST_INTERFLOP;
   }
 
+  /* Check that the function is in the scope given by --only-obj */
+  /* and --only-fn. Interflop backends are counted in any case   */
+  if (objVerdict & OBJ_VERDICT_OUTSIDE) {
+    return INST_IGNORE;
+  }
+  if (Matcher_Size(onlyFunctions) > 0 &&
+      !Matcher_Match(onlyFunctions, di->function)) {
+    return INST_IGNORE;
+  }
+
   return INST_IEEE;
   
 }   
 
+InstType get_InstType(const DebugInfo *di) {
+
+  /* Unknown function */
+  if (di->symId == UNK_SYMID) {
+    return INST_IGNORE;
+  }
+
+  SymVerdict *verdict = get_sym_verdict(di->symId);
+  UChar *cached = (di->isEntry) ? &verdict->atEntry : &verdict->inBody;
+  if (*cached == SYM_VERDICT_UNKNOWN) {
+    *cached = compute_InstType(di);
+  }
+  return (InstType)*cached;
+}
+
+/*--------------------------------------------------------------------*/
+/*--- Interflop entries                                            ---*/
+/*--------------------------------------------------------------------*/
+
+/* Verdict of an address where a superblock, or a chased part of a  */
+/* superblock, starts: True if it is the entry of an Interflop      */
+/* function. Both verdicts are cached, so the debug info of an      */
+/* address is resolved once until its code is unmapped.             */
+typedef struct _EntryVerdict EntryVerdict;
+struct _EntryVerdict {
+  Addr addr;
+  Bool isInterflop;
+};
+
+static OSet *entryVerdicts = NULL;
+
+void init_interflop_entries(void) {
+  entryVerdicts = VG_(OSetGen_Create)(offsetof(EntryVerdict, addr),
+				      NULL,
+				      VG_(malloc),
+				      "entryverdict.init",
+				      VG_(free));
+}
+
+Bool is_interflop_entry(Addr a) {
+  const DebugInfo *di;
+  EntryVerdict *verdict = VG_(OSetGen_Lookup)(entryVerdicts, &a);
+
+  if (verdict) {
+    return verdict->isInterflop;
+  }
+
+  verdict = VG_(OSetGen_AllocNode)(entryVerdicts, sizeof(EntryVerdict));
+  verdict->addr = a;
+  verdict->isInterflop = False;
+  /* Most addresses are not entries and need no name */
+  if (isFunctionEntryAt(a)) {
+    di = getDebugInfoAt(a);
+    verdict->isInterflop = di->isEntry && (get_InstType(di) == INST_INTERFLOP);
+  }
+  VG_(OSetGen_Insert)(entryVerdicts, verdict);
+  return verdict->isInterflop;
+}
+
+void remove_interflop_entries(Addr a, SizeT len) {
+  EntryVerdict *verdict;
+  Word i;
+
+  if (entryVerdicts == NULL || len == 0) {
+    return;
+  }
+
+  /* The set cannot be modified while iterating */
+  XArray *dropped = VG_(newXA)(VG_(malloc), "entryverdict.remove",
+			       VG_(free), sizeof(Addr));
+  VG_(OSetGen_ResetIter)(entryVerdicts);
+  while ( (verdict = VG_(OSetGen_Next)(entryVerdicts)) ) {
+    if (a <= verdict->addr && verdict->addr < a + len) {
+      VG_(addToXA)(dropped, &verdict->addr);
+    }
+  }
+  for (i = 0; i < VG_(sizeXA)(dropped); i++) {
+    verdict = VG_(OSetGen_Remove)(entryVerdicts, VG_(indexXA)(dropped, i));
+    VG_(OSetGen_FreeNode)(entryVerdicts, verdict);
+  }
+  VG_(deleteXA)(dropped);
+}
@@ -31,8 +31,6 @@
 
 /* This module checks the included/excluded symbols */
 
-#define IGNORED_LIBS_SIZE_DEFAULT 128
-
 /* Enum that defines the type of instrumentation */
 /* INST_IGNORE: ignore that function */
 /* INST_IEEE:  function have IEEE fp operations */
@@ -44,8 +42,54 @@ enum _InstType {
 		INST_INTERFLOP
 };
 
+/* Lists of patterns that restrict the instrumentation      */
+/* SCOPE_IGNORE_OBJ: objects (library or binary) to ignore  */
+/* SCOPE_IGNORE_FN : functions to ignore                    */
+/* SCOPE_ONLY_OBJ  : if not empty, objects to instrument    */
+/* SCOPE_ONLY_FN   : if not empty, functions to instrument  */
+typedef enum _ScopeList ScopeList;
+enum _ScopeList {
+		 SCOPE_IGNORE_OBJ = 0,
+		 SCOPE_IGNORE_FN,
+		 SCOPE_ONLY_OBJ,
+		 SCOPE_ONLY_FN
+};
+
+/* Compiles the default scope lists into matchers (see vc_match.h) */
 void init_ignored_libs_default(void);
-Bool isExcludedLib(const HChar *lib);
+void free_ignored_libs(void);
+
+/* Adds a glob pattern to a scope list */
+void add_scope_pattern(ScopeList list, const HChar *pattern);
+
+/* Adds the patterns of a scope file, one per line:           */
+/*   <ignore-obj|ignore-fn|only-obj|only-fn> <pattern>        */
+/* Empty lines and lines starting with '#' are skipped.       */
+/* Returns False if the file cannot be read or is malformed   */
+Bool load_scope_file(const HChar *path);
+
+/* Returns the instrumentation type of di                  */
+/* Verdicts are cached per symbol, and the verdict of the  */
+/* object (library or binary) is cached per mapped object  */
 InstType get_InstType(const DebugInfo *di);
 
+/* Object verdict cache                                     */
+/* - init  : Creates the cache                              */
+/* - add   : Records the executable mapping [a, a+len) of   */
+/*           an object and computes its verdict if its name */
+/*           is already known                               */
+/* - remove: Drops the mappings overlapping [a, a+len)      */
+void init_obj_verdicts(void);
+void add_obj_verdict(Addr a, SizeT len);
+void remove_obj_verdicts(Addr a, SizeT len);
+
+/* Interflop entry cache                                    */
+/* - init  : Creates the cache                              */
+/* - is    : Returns True if a is the entry of an Interflop */
+/*           function, computed once per address            */
+/* - remove: Drops the addresses in [a, a+len)              */
+void init_interflop_entries(void);
+Bool is_interflop_entry(Addr a);
+void remove_interflop_entries(Addr a, SizeT len);
+
 #endif /* __VC_IENAME_H__ */
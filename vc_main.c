@@ -38,14 +38,41 @@
 #include "pub_tool_libcassert.h"
 #include "pub_tool_libcbase.h"
 #include "pub_tool_seqmatch.h"
+#include "pub_tool_options.h"
+#include "pub_tool_clientstate.h"
+#include "pub_tool_libcproc.h"
+#include "pub_tool_transtab.h"
+#include "pub_tool_oset.h"
+#include "pub_tool_aspacemgr.h"
+#include "pub_tool_vki.h"
 
 #include "valgrind.h"
+#include "vericheck.h"
 
 #include "vc_fpops.h"
 #include "vc_container.h"
 #include "vc_utils.h"
 #include "vc_iesym.h"
 #include "vc_debuginfo.h"
+#include "vc_context.h"
+#include "vc_region.h"
+#include "vc_output.h"
+
+#if VG_WORDSIZE == 8
+#   define HWORD_TY  Ity_I64
+#   define HWORD_ADD Iop_Add64
+#else
+#   define HWORD_TY  Ity_I32
+#   define HWORD_ADD Iop_Add32
+#endif
+
+#if defined(VG_BIGENDIAN)
+#   define END Iend_BE
+#elif defined(VG_LITTLEENDIAN)
+#   define END Iend_LE
+#else
+#   error "Unknown endianness"
+#endif
 
 /* Total number of visited functions */
 static ULong nbVisitedFuns = 0;
@@ -56,11 +83,184 @@ static FPCounter* ieeeFPC = NULL;
 /* Interflop FP Counter */
 static FPCounter* ifFPC = NULL;
 
+/* IEEE op-mix counter                                          */
+/* OPMIX_NB_CELLS counters per IEEE function (see vc_fpops.h),  */
+/* the counter of a cell is at funNo * OPMIX_NB_CELLS + cell    */
+static FPCounter* opMixFPC = NULL;
+
+/* IEEE load/store bytes counter                                */
+/* BYTES_NB_CELLS counters per IEEE function, the counter of a  */
+/* cell is at funNo * BYTES_NB_CELLS + cell                     */
+/* FP cells count FP and vector types (F32, F64, V128, V256...) */
+#define BYTES_FP_LOAD    0
+#define BYTES_FP_STORE   1
+#define BYTES_INT_LOAD   2
+#define BYTES_INT_STORE  3
+#define BYTES_NB_CELLS   4
+static FPCounter* bytesFPC = NULL;
+
+/* Command line options */
+/* --batch-counts: accumulate the FP cost of each superblock segment */
+/*                 at translation time and emit one increment per    */
+/*                 counter and segment instead of one per statement. */
+static Bool clo_batch_counts = True;
+/* --inline-counts: emit the increments as plain IR (load, add, store) */
+/*                  instead of calling the increment_detail helper.    */
+static Bool clo_inline_counts = True;
+/* --op-mix: count the IEEE FP operations of each function by */
+/*           precision, operation and vector width.          */
+static Bool clo_op_mix = False;
+/* --flop-model: weight of an IEEE FP operation                   */
+/*   FLOP_MODEL_INSTRUCTIONS: one per computed lane               */
+/*   FLOP_MODEL_FLOPS       : FLOPs per computed lane (FMA is 2,  */
+/*                            Neg and Abs are 0)                  */
+typedef enum _FlopModel FlopModel;
+enum _FlopModel {
+		 FLOP_MODEL_INSTRUCTIONS = 0,
+		 FLOP_MODEL_FLOPS
+};
+static FlopModel clo_flop_model = FLOP_MODEL_INSTRUCTIONS;
+/* --count-bytes: count the bytes loaded and stored by each IEEE   */
+/*                function, split into FP/vector and integer types */
+static Bool clo_count_bytes = False;
+/* --per-thread: count the FP operations of each thread */
+static Bool clo_per_thread = False;
+/* --context-depth: attribute the FP operations to calling contexts */
+/*                  of this number of functions, 0 to disable      */
+static Int clo_context_depth = 0;
+/* --granularity: unit of attribution of the FP operations         */
+/*   GRANULARITY_TOTAL   : one counter for the whole execution     */
+/*   GRANULARITY_OBJECT  : per object (library or binary)          */
+/*   GRANULARITY_FUNCTION: per function                            */
+/*   GRANULARITY_LINE    : per function and per source line        */
+/*   GRANULARITY_CONTEXT : per function and per calling context    */
+/* The coarser ones come first                                     */
+typedef enum _Granularity Granularity;
+enum _Granularity {
+		   GRANULARITY_TOTAL = 0,
+		   GRANULARITY_OBJECT,
+		   GRANULARITY_FUNCTION,
+		   GRANULARITY_LINE,
+		   GRANULARITY_CONTEXT
+};
+/* Context depth of --granularity=context without --context-depth */
+#define DEFAULT_CONTEXT_DEPTH 4
+static Granularity clo_granularity = GRANULARITY_FUNCTION;
+/* --line-addrs: with --granularity=line, split the lines by */
+/*               guest instruction address                  */
+static Bool clo_line_addrs = False;
+/* --callgrind-out: write a callgrind-format profile, it implies */
+/*                  --granularity=line, and cannot be used with  */
+/*                  total, object or context                     */
+static Bool clo_callgrind_out = False;
+/* --callgrind-out-file: name of the profile, %p is the pid */
+static const HChar *clo_callgrind_out_file = "vericheck.out.%p";
+/* --vc-out-file: write the profile of each function in this file, */
+/*                %p is the pid                                   */
+static const HChar *clo_vc_out_file = NULL;
+/* --vc-out-format: format of the profile */
+typedef enum _OutFormat OutFormat;
+enum _OutFormat {
+		 OUT_FORMAT_JSON = 0,
+		 OUT_FORMAT_CSV
+};
+static OutFormat clo_vc_out_format = OUT_FORMAT_JSON;
+/* --collect-atstart: count from the start of the execution, */
+/*                     otherwise wait for VERICHECK_START     */
+static Bool clo_collect_atstart = True;
+/* --sample-rate: count one execution out of N of each superblock */
+/*                and scale the counts by N, 1 counts them all   */
+static Long clo_sample_rate = 1;
+/* --sample-seed: seed of the sampling phases */
+static Long clo_sample_seed = 0;
+/* --snapshot-interval: write a snapshot of the counters every */
+/*                      interval units, 0 to disable          */
+static Long clo_snapshot_interval = 0;
+/* --snapshot-unit: unit of the interval                         */
+/*   SNAPSHOT_UNIT_INSTRS: guest instructions, in any code        */
+/*   SNAPSHOT_UNIT_FP    : IEEE FP operations and Interflop calls */
+typedef enum _SnapshotUnit SnapshotUnit;
+enum _SnapshotUnit {
+		    SNAPSHOT_UNIT_INSTRS = 0,
+		    SNAPSHOT_UNIT_FP
+};
+static SnapshotUnit clo_snapshot_unit = SNAPSHOT_UNIT_FP;
+/* --snapshot-mode: counts since the previous snapshot (delta) */
+/*                  or since the start (cumulative)            */
+typedef enum _SnapshotMode SnapshotMode;
+enum _SnapshotMode {
+		    SNAPSHOT_MODE_DELTA = 0,
+		    SNAPSHOT_MODE_CUMULATIVE
+};
+static SnapshotMode clo_snapshot_mode = SNAPSHOT_MODE_DELTA;
+/* --snapshot-file: name of the snapshots file, %p is the pid */
+static const HChar *clo_snapshot_file = "vericheck.snapshots.%p";
+/* Number of functions printed with their lines */
+#define LINE_REPORT_FUNCTIONS 10
+
+/* IEEE source lines counter */
+static LineContainer *ieeeLNC = NULL;
+
+/* Collection state, toggled by VERICHECK_START and VERICHECK_STOP */
+/* Superblocks are not instrumented while collection is stopped    */
+static Bool collecting = True;
+/* Running totals of the execution, kept by the instrumented code */
+/* so that VERICHECK_GET_COUNTS does not walk the containers       */
+static ULong ieeeTotal = 0;
+static ULong ifTotal = 0;
+/* Set by the first VERICHECK_REGION_BEGIN, the counts are then */
+/* also charged to the region of the running thread             */
+static Bool regionsActive = False;
+/* Number of the next VERICHECK_DUMP */
+static Int nbDumps = 0;
+
+/* Snapshots                                                     */
+/* The cost of a segment (see the batched increments) is known   */
+/* at translation time, so the countdown is decremented once per */
+/* segment and the snapshot helper is only called, through a     */
+/* guarded dirty call, when the countdown reaches 0.             */
+/* - snapshotCountdown: units left before the next snapshot       */
+/* - snapshotPosition : units elapsed at the last snapshot        */
+/* - snapshotNo       : number of the next snapshot               */
+/* - ieeePrevFPC, ifPrevFPC: counters at the last snapshot, for   */
+/*                           the delta mode                      */
+static Long snapshotCountdown = 0;
+static ULong snapshotPosition = 0;
+static ULong snapshotNo = 0;
+static Output *snapshotOut = NULL;
+static FPCounter *ieeePrevFPC = NULL;
+static FPCounter *ifPrevFPC = NULL;
+/* Cost of the segment being instrumented */
+static ULong segmentCost = 0;
+
+/* Per-thread counters                                            */
+/* Each thread has its own slab, aligned on a cache line so that  */
+/* threads running on different cores do not share lines.         */
+/* The instrumented code reaches the slab of the running thread   */
+/* through curThreadSlab, updated when a thread starts running    */
+/* client code (threads are serialised by the Valgrind core)      */
+#define THREAD_SLAB_ALIGN 64
+
+typedef struct _ThreadSlab ThreadSlab;
+struct _ThreadSlab {
+  ULong ieee;
+  ULong interflop;
+  Bool seen;
+} __attribute__((aligned(THREAD_SLAB_ALIGN)));
+
+static ThreadSlab *threadSlabs = NULL;
+static void *threadSlabsBlock = NULL;
+static ThreadSlab *curThreadSlab = NULL;
+
 /* IEEE Functions Container */
 static FnContainer *ieeeFNC = NULL;
 /* Interflop Functions Container */
 static FnContainer *ifFNC = NULL;
 
+/* Guard of the sampled executions of the superblock being */
+/* instrumented, see the sampling below                     */
+static IRTemp sampleGuard = IRTemp_INVALID;
+
 /* The helper that is called from the instrumented code. */
 static VG_REGPARM(1)
 void increment_detail(ULong* detail, ULong inc)
@@ -68,33 +268,690 @@ void increment_detail(ULong* detail, ULong inc)
   (*detail) += inc;
 }
 
+/* The helper for counters reached through a pointer */
+static VG_REGPARM(3)
+void increment_indirect(HWord* base, HWord offset, ULong inc)
+{
+  (*(ULong*)(*base + offset)) += inc;
+}
+
+/* Adds the increment as plain IR: */
+/*   t1 = LDle:I64(detail)          */
+/*   t2 = Add64(t1, increment)      */
+/*   STle(detail) = t2              */
+/* No helper call, so the guest state is neither spilled nor */
+/* reloaded and the JIT can optimise around the increment.   */
+static void instrument_detail_inline(IRSB* sb, ULong *detail, ULong increment)
+{
+   IRExpr* addr = mkIRExpr_HWord( (HWord)detail );
+   IRTemp t1 = newIRTemp(sb->tyenv, Ity_I64);
+   IRTemp t2 = newIRTemp(sb->tyenv, Ity_I64);
+
+   addStmtToIRSB( sb, IRStmt_WrTmp(t1, IRExpr_Load(END, Ity_I64, addr)) );
+   addStmtToIRSB( sb, IRStmt_WrTmp(t2, IRExpr_Binop(Iop_Add64,
+						    IRExpr_RdTmp(t1),
+						    IRExpr_Const(IRConst_U64(increment)))) );
+   addStmtToIRSB( sb, IRStmt_Store(END, addr, IRExpr_RdTmp(t2)) );
+}
+
 /* A helper that adds the instrumentation for a detail.  */
-static void instrument_detail(IRSB* sb, FPCounter *counter, ULong fun_no, ULong increment)
+static void instrument_detail(IRSB* sb, ULong *detail, ULong increment)
+{
+   IRDirty* di;
+   IRExpr** argv;
+
+   if (clo_inline_counts) {
+     instrument_detail_inline(sb, detail, increment);
+     return;
+   }
+
+   argv = mkIRExprVec_2( mkIRExpr_HWord( (HWord)detail ),
+			 mkIRExpr_HWord( (HWord)increment )
+			 );
+   di = unsafeIRDirty_0_N( 1, "increment_detail",
+                              VG_(fnptr_to_fnentry)( &increment_detail ),
+                              argv);
+   addStmtToIRSB( sb, IRStmt_Dirty(di) );
+}
+
+/* Adds the increment at (*base + offset) as plain IR: */
+/*   t1 = LDle:HWord(base)                             */
+/*   t2 = Add(t1, offset)                              */
+/*   t3 = LDle:I64(t2)                                 */
+/*   t4 = Add64(t3, increment)                         */
+/*   STle(t2) = t4                                     */
+static void instrument_indirect_inline(IRSB* sb, HWord *base, HWord offset,
+				       ULong increment)
+{
+   IRTemp t1 = newIRTemp(sb->tyenv, HWORD_TY);
+   IRTemp t2 = newIRTemp(sb->tyenv, HWORD_TY);
+   IRTemp t3 = newIRTemp(sb->tyenv, Ity_I64);
+   IRTemp t4 = newIRTemp(sb->tyenv, Ity_I64);
+
+   addStmtToIRSB( sb, IRStmt_WrTmp(t1, IRExpr_Load(END, HWORD_TY,
+						   mkIRExpr_HWord( (HWord)base ))) );
+   addStmtToIRSB( sb, IRStmt_WrTmp(t2, IRExpr_Binop(HWORD_ADD,
+						    IRExpr_RdTmp(t1),
+						    mkIRExpr_HWord(offset))) );
+   addStmtToIRSB( sb, IRStmt_WrTmp(t3, IRExpr_Load(END, Ity_I64, IRExpr_RdTmp(t2))) );
+   addStmtToIRSB( sb, IRStmt_WrTmp(t4, IRExpr_Binop(Iop_Add64,
+						    IRExpr_RdTmp(t3),
+						    IRExpr_Const(IRConst_U64(increment)))) );
+   addStmtToIRSB( sb, IRStmt_Store(END, IRExpr_RdTmp(t2), IRExpr_RdTmp(t4)) );
+}
+
+/* A helper that adds the instrumentation for a counter */
+/* reached through a pointer                            */
+static void instrument_indirect(IRSB* sb, HWord *base, HWord offset,
+				ULong increment)
+{
+   IRDirty* di;
+   IRExpr** argv;
+
+   if (clo_inline_counts) {
+     instrument_indirect_inline(sb, base, offset, increment);
+     return;
+   }
+
+   argv = mkIRExprVec_3( mkIRExpr_HWord( (HWord)base ),
+			 mkIRExpr_HWord( offset ),
+			 mkIRExpr_HWord( (HWord)increment )
+			 );
+   di = unsafeIRDirty_0_N( 3, "increment_indirect",
+                              VG_(fnptr_to_fnentry)( &increment_indirect ),
+                              argv);
+   addStmtToIRSB( sb, IRStmt_Dirty(di) );
+}
+
+/* Adds the increment if guard (an Ity_I1 atom) is true      */
+/* Guarded statements (LoadG, StoreG) are not batched since   */
+/* their cost is only known at run time                       */
+static void instrument_detail_guarded(IRSB* sb, ULong *detail, ULong increment,
+				      IRExpr *guard)
 {
    IRDirty* di;
    IRExpr** argv;
 
-   argv = mkIRExprVec_2( mkIRExpr_HWord( (HWord)&(counter->data[fun_no]) ),
+   /* Sampled executions only */
+   if (sampleGuard != IRTemp_INVALID) {
+     IRTemp g = newIRTemp(sb->tyenv, Ity_I1);
+     addStmtToIRSB( sb, IRStmt_WrTmp(g, IRExpr_ITE(IRExpr_RdTmp(sampleGuard),
+						   guard,
+						   IRExpr_Const(IRConst_U1(False)))) );
+     guard = IRExpr_RdTmp(g);
+     increment *= clo_sample_rate;
+   }
+
+   if (clo_inline_counts) {
+     IRExpr* addr = mkIRExpr_HWord( (HWord)detail );
+     IRTemp t1 = newIRTemp(sb->tyenv, Ity_I64);
+     IRTemp t2 = newIRTemp(sb->tyenv, Ity_I64);
+     IRTemp t3 = newIRTemp(sb->tyenv, Ity_I64);
+
+     addStmtToIRSB( sb, IRStmt_WrTmp(t1, IRExpr_ITE(guard,
+						    IRExpr_Const(IRConst_U64(increment)),
+						    IRExpr_Const(IRConst_U64(0)))) );
+     addStmtToIRSB( sb, IRStmt_WrTmp(t2, IRExpr_Load(END, Ity_I64, addr)) );
+     addStmtToIRSB( sb, IRStmt_WrTmp(t3, IRExpr_Binop(Iop_Add64,
+						      IRExpr_RdTmp(t2),
+						      IRExpr_RdTmp(t1))) );
+     addStmtToIRSB( sb, IRStmt_Store(END, addr, IRExpr_RdTmp(t3)) );
+     return;
+   }
+
+   argv = mkIRExprVec_2( mkIRExpr_HWord( (HWord)detail ),
 			 mkIRExpr_HWord( (HWord)increment )
 			 );
    di = unsafeIRDirty_0_N( 1, "increment_detail",
                               VG_(fnptr_to_fnentry)( &increment_detail ),
                               argv);
+   di->guard = guard;
+   addStmtToIRSB( sb, IRStmt_Dirty(di) );
+}
+
+/* Batched increments                                            */
+/* A superblock is split into segments at each Ist_Exit.         */
+/* The FP cost of a segment is accumulated at translation time   */
+/* for each counter, and one increment per counter is emitted    */
+/* before the side exit (or at the end of the superblock).       */
+/* Every statement of a segment is executed before the exit that */
+/* closes it, so counts stay exact whatever exit is taken.       */
+#define MAX_PENDING_INCS 64
+
+/* Pending increment                                          */
+/* - base  : NULL if the counter is at the address offset,    */
+/*           otherwise the counter is at (*base + offset)     */
+/* - offset: Address or offset of the counter                 */
+/* - inc   : Accumulated increment                            */
+typedef struct _PendingInc PendingInc;
+struct _PendingInc {
+  HWord *base;
+  HWord offset;
+  ULong inc;
+};
+
+static PendingInc pendingIncs[MAX_PENDING_INCS];
+static UInt nbPendingIncs = 0;
+
+/* Sampling                                                         */
+/* With --sample-rate=1/N, each superblock has a countdown, started  */
+/* at a pseudo-random phase in [1, N], that selects one execution    */
+/* out of N. The pending increments of a segment, scaled by N, are   */
+/* saved in a SampleBatch and applied by a single dirty call guarded */
+/* by the countdown, so the other executions only pay a test.        */
+/* - sampleGuard : Ity_I1 temporary, true if the execution of the    */
+/*                 superblock being instrumented is sampled, or      */
+/*                 IRTemp_INVALID if it has no countdown yet         */
+/* - sampleBlocks: Countdown and batches of each translated          */
+/*                 superblock, keyed by its guest address. They are  */
+/*                 reused by its next translations, and freed when   */
+/*                 its translations are discarded.                   */
+/* - sampleState : State of the xorshift generator of the phases     */
+/* - ieeeSumSq, ifSumSq: Sums of the squared costs of the sampled    */
+/*                 segments, scaled by N, for the variance           */
+typedef struct _SampleBatch SampleBatch;
+struct _SampleBatch {
+  SampleBatch *next;
+  UInt nbIncs;
+  PendingInc incs[];
+};
+
+typedef struct _SampleBlock SampleBlock;
+struct _SampleBlock {
+  Addr addr;
+  ULong countdown;
+  SampleBatch *batches;
+};
+
+static OSet *sampleBlocks = NULL;
+/* Sampling data of the superblock being instrumented */
+static SampleBlock *curSampleBlock = NULL;
+static ULong sampleState = 0;
+static ULong ieeeSumSq = 0;
+static ULong ifSumSq = 0;
+/* FP costs of the segment being instrumented */
+static ULong segmentIeee = 0;
+static ULong segmentIf = 0;
+
+static VG_REGPARM(0) void snapshot_take(void);
+
+/* Applies the scaled increments of a sampled segment */
+static VG_REGPARM(1)
+void apply_sample(const SampleBatch *batch)
+{
+  UInt i;
+  for (i = 0; i < batch->nbIncs; i++) {
+    const PendingInc *pending = &batch->incs[i];
+    if (pending->base == NULL) {
+      (*(ULong*)pending->offset) += pending->inc;
+    } else {
+      (*(ULong*)(*pending->base + pending->offset)) += pending->inc;
+    }
+  }
+  if (clo_snapshot_interval > 0 && snapshotCountdown <= 0) {
+    snapshot_take();
+  }
+}
+
+/* Returns the next phase of a superblock countdown, in [1, N] */
+static ULong next_sample_phase(void)
+{
+  sampleState ^= sampleState << 13;
+  sampleState ^= sampleState >> 7;
+  sampleState ^= sampleState << 17;
+  return 1 + sampleState % clo_sample_rate;
+}
+
+static void free_sample_batches(SampleBlock *block)
+{
+  while (block->batches) {
+    SampleBatch *next = block->batches->next;
+    VG_(free)(block->batches);
+    block->batches = next;
+  }
+}
+
+/* Returns the sampling data of the superblock at addr         */
+/* A superblock is translated again after its translation was  */
+/* discarded, so the batches of the previous one are not used  */
+/* anymore, its countdown is kept                              */
+static SampleBlock* get_sample_block(Addr addr)
+{
+  SampleBlock *block = VG_(OSetGen_Lookup)(sampleBlocks, &addr);
+  if (block) {
+    free_sample_batches(block);
+    return block;
+  }
+  block = VG_(OSetGen_AllocNode)(sampleBlocks, sizeof(SampleBlock));
+  block->addr = addr;
+  block->countdown = next_sample_phase();
+  block->batches = NULL;
+  VG_(OSetGen_Insert)(sampleBlocks, block);
+  return block;
+}
+
+/* Frees the sampling data of a discarded superblock */
+static void vc_discard_superblock_info(Addr orig_addr, VexGuestExtents vge)
+{
+  SampleBlock *block;
+  if (sampleBlocks == NULL) {
+    return;
+  }
+  block = VG_(OSetGen_Remove)(sampleBlocks, &orig_addr);
+  if (block) {
+    free_sample_batches(block);
+    VG_(OSetGen_FreeNode)(sampleBlocks, block);
+  }
+}
+
+/* Adds the countdown of the superblock and sets sampleGuard:      */
+/*   t1 = LDle:I64(countdown)                                      */
+/*   t2 = Sub64(t1, 1)                                             */
+/*   t3 = CmpEQ64(t2, 0)                                           */
+/*   t4 = ITE(t3, N, t2)                                           */
+/*   STle(countdown) = t4                                          */
+static void instrument_sample_countdown(IRSB* sb)
+{
+  IRExpr* addr;
+  IRTemp t1 = newIRTemp(sb->tyenv, Ity_I64);
+  IRTemp t2 = newIRTemp(sb->tyenv, Ity_I64);
+  IRTemp t3 = newIRTemp(sb->tyenv, Ity_I1);
+  IRTemp t4 = newIRTemp(sb->tyenv, Ity_I64);
+
+  addr = mkIRExpr_HWord( (HWord)&curSampleBlock->countdown );
+
+  addStmtToIRSB( sb, IRStmt_WrTmp(t1, IRExpr_Load(END, Ity_I64, addr)) );
+  addStmtToIRSB( sb, IRStmt_WrTmp(t2, IRExpr_Binop(Iop_Sub64,
+						   IRExpr_RdTmp(t1),
+						   IRExpr_Const(IRConst_U64(1)))) );
+  addStmtToIRSB( sb, IRStmt_WrTmp(t3, IRExpr_Binop(Iop_CmpEQ64,
+						   IRExpr_RdTmp(t2),
+						   IRExpr_Const(IRConst_U64(0)))) );
+  addStmtToIRSB( sb, IRStmt_WrTmp(t4, IRExpr_ITE(IRExpr_RdTmp(t3),
+						 IRExpr_Const(IRConst_U64(clo_sample_rate)),
+						 IRExpr_RdTmp(t2))) );
+  addStmtToIRSB( sb, IRStmt_Store(END, addr, IRExpr_RdTmp(t4)) );
+  sampleGuard = t3;
+}
+
+/* Emits the pending increments as a sampled batch */
+static void instrument_sample_batch(IRSB* sb)
+{
+  IRDirty* di;
+  UInt i;
+  SampleBatch *batch = VG_(malloc)("sample.batch", sizeof(SampleBatch) +
+				   nbPendingIncs * sizeof(PendingInc));
+
+  batch->nbIncs = nbPendingIncs;
+  for (i = 0; i < nbPendingIncs; i++) {
+    batch->incs[i] = pendingIncs[i];
+    batch->incs[i].inc *= clo_sample_rate;
+  }
+  batch->next = curSampleBlock->batches;
+  curSampleBlock->batches = batch;
+
+  di = unsafeIRDirty_0_N( 1, "apply_sample",
+			  VG_(fnptr_to_fnentry)( &apply_sample ),
+			  mkIRExprVec_1( mkIRExpr_HWord( (HWord)batch ) ) );
+  di->guard = IRExpr_RdTmp(sampleGuard);
+  addStmtToIRSB( sb, IRStmt_Dirty(di) );
+}
+
+/* Emits a pending increment */
+static void instrument_pending(IRSB* sb, const PendingInc *pending)
+{
+  if (pending->base == NULL) {
+    instrument_detail(sb, (ULong*)pending->offset, pending->inc);
+  } else {
+    instrument_indirect(sb, pending->base, pending->offset, pending->inc);
+  }
+}
+
+/* Emits the pending increments of the current segment */
+static void flush_pending(IRSB* sb)
+{
+  UInt i;
+  if (nbPendingIncs > 0 && sampleGuard != IRTemp_INVALID) {
+    instrument_sample_batch(sb);
+  } else {
+    for (i = 0; i < nbPendingIncs; i++) {
+      instrument_pending(sb, &pendingIncs[i]);
+    }
+  }
+  nbPendingIncs = 0;
+}
+
+/* Adds inc to the pending increment of (base, offset) */
+/* Flushes early if the pending table is full, which is still */
+/* exact since all the pending statements precede the flush   */
+static void add_pending(IRSB* sb, HWord *base, HWord offset, ULong inc)
+{
+  UInt i;
+  for (i = 0; i < nbPendingIncs; i++) {
+    if (pendingIncs[i].base == base && pendingIncs[i].offset == offset) {
+      pendingIncs[i].inc += inc;
+      return;
+    }
+  }
+  if (nbPendingIncs == MAX_PENDING_INCS) {
+    flush_pending(sb);
+  }
+  pendingIncs[nbPendingIncs].base = base;
+  pendingIncs[nbPendingIncs].offset = offset;
+  pendingIncs[nbPendingIncs].inc = inc;
+  nbPendingIncs++;
+}
+
+/* Counts inc for the counter at (*base + offset), or at offset */
+/* if base is NULL, either now or at the end of the segment     */
+static void count_indirect(IRSB* sb, HWord *base, HWord offset, ULong inc)
+{
+  PendingInc pending;
+  if (clo_batch_counts) {
+    add_pending(sb, base, offset, inc);
+  } else {
+    pending.base = base;
+    pending.offset = offset;
+    pending.inc = inc;
+    instrument_pending(sb, &pending);
+  }
+}
+
+/* Adds cost to the current segment if unit is the snapshot unit */
+static void count_snapshot(SnapshotUnit unit, ULong cost)
+{
+  if (clo_snapshot_interval > 0 && clo_snapshot_unit == unit) {
+    segmentCost += cost;
+  }
+}
+
+/* Writes the counters of the functions of FNC that changed, */
+/* and their total, in the snapshots file                    */
+static void dump_snapshot_counters(const HChar *kind, FnContainer *FNC,
+				   FPCounter *FPC, FPCounter *prevFPC)
+{
+  ContainerObj *it = NULL;
+  ULong total = 0;
+
+  while (size_FPCounter(prevFPC) < size_FPCounter(FPC)) {
+    increment_FPCounter(prevFPC);
+  }
+
+  FnContainer_ResetIterator(FNC);
+  while ( (it = FnContainer_Next(FNC)) ) {
+    const ULong count = get_FPCounter(FPC, it->ID);
+    ULong *prev = addr_FPCounter(prevFPC, it->ID);
+    const ULong value = (clo_snapshot_mode == SNAPSHOT_MODE_DELTA)
+      ? count - *prev : count;
+    *prev = count;
+    total += value;
+    if (value == 0) {
+      continue;
+    }
+    Output_Printf(snapshotOut, "%llu,%llu,%s,", snapshotNo, snapshotPosition,
+		  kind);
+    Output_CSVString(snapshotOut, it->libName);
+    Output_Printf(snapshotOut, ",");
+    Output_CSVString(snapshotOut, it->fileName);
+    Output_Printf(snapshotOut, ",");
+    Output_CSVString(snapshotOut, it->functionName);
+    Output_Printf(snapshotOut, ",%llu\n", value);
+  }
+  Output_Printf(snapshotOut, "%llu,%llu,%s_total,,,,%llu\n", snapshotNo,
+		snapshotPosition, kind, total);
+}
+
+/* Takes a snapshot: called from the instrumented code when the */
+/* countdown reaches 0, and once at the end of the execution    */
+static VG_REGPARM(0)
+void snapshot_take(void)
+{
+  snapshotPosition += clo_snapshot_interval - snapshotCountdown;
+  snapshotCountdown = clo_snapshot_interval;
+  dump_snapshot_counters("ieee", ieeeFNC, ieeeFPC, ieeePrevFPC);
+  dump_snapshot_counters("interflop", ifFNC, ifFPC, ifPrevFPC);
+  snapshotNo++;
+}
+
+/* Decrements the countdown by the cost of the segment and */
+/* takes a snapshot if it is reached:                      */
+/*   t1 = LDle:I64(&snapshotCountdown)                     */
+/*   t2 = Sub64(t1, cost)                                  */
+/*   STle(&snapshotCountdown) = t2                         */
+/*   t3 = CmpLE64S(t2, 0)                                  */
+/*   if (t3) snapshot_take()                               */
+static void instrument_snapshot(IRSB* sb, ULong cost)
+{
+   IRDirty* di;
+   IRExpr* addr = mkIRExpr_HWord( (HWord)&snapshotCountdown );
+   IRTemp t1 = newIRTemp(sb->tyenv, Ity_I64);
+   IRTemp t2 = newIRTemp(sb->tyenv, Ity_I64);
+   IRTemp t3 = newIRTemp(sb->tyenv, Ity_I1);
+
+   addStmtToIRSB( sb, IRStmt_WrTmp(t1, IRExpr_Load(END, Ity_I64, addr)) );
+   addStmtToIRSB( sb, IRStmt_WrTmp(t2, IRExpr_Binop(Iop_Sub64,
+						    IRExpr_RdTmp(t1),
+						    IRExpr_Const(IRConst_U64(cost)))) );
+   addStmtToIRSB( sb, IRStmt_Store(END, addr, IRExpr_RdTmp(t2)) );
+   addStmtToIRSB( sb, IRStmt_WrTmp(t3, IRExpr_Binop(Iop_CmpLE64S,
+						    IRExpr_RdTmp(t2),
+						    IRExpr_Const(IRConst_U64(0)))) );
+   di = unsafeIRDirty_0_N( 0, "snapshot_take",
+			   VG_(fnptr_to_fnentry)( &snapshot_take ),
+			   mkIRExprVec_0() );
+   di->guard = IRExpr_RdTmp(t3);
    addStmtToIRSB( sb, IRStmt_Dirty(di) );
 }
 
+/* Closes the current segment: emits its pending increments */
+/* and decrements the snapshot countdown by its cost        */
+/* When sampling, the squared costs of the segment and its snapshot */
+/* cost join the batch, apply_sample checks the snapshot countdown  */
+static void flush_segment(IRSB* sb)
+{
+  if (sampleGuard != IRTemp_INVALID) {
+    if (segmentIeee > 0) {
+      add_pending(sb, NULL, (HWord)&ieeeSumSq, segmentIeee * segmentIeee);
+    }
+    if (segmentIf > 0) {
+      add_pending(sb, NULL, (HWord)&ifSumSq, segmentIf * segmentIf);
+    }
+    if (segmentCost > 0) {
+      add_pending(sb, NULL, (HWord)&snapshotCountdown, -segmentCost);
+      segmentCost = 0;
+    }
+  }
+  segmentIeee = segmentIf = 0;
+  flush_pending(sb);
+  if (segmentCost > 0) {
+    instrument_snapshot(sb, segmentCost);
+    segmentCost = 0;
+  }
+}
+
+/* Counts inc for detail, either now or at the end of the segment */
+static void count_detail(IRSB* sb, ULong *detail, ULong inc)
+{
+  count_indirect(sb, NULL, (HWord)detail, inc);
+}
+
+/* Counts inc in the slab of the running thread */
+static void count_thread(IRSB* sb, HWord offset, ULong inc)
+{
+  count_indirect(sb, (HWord*)&curThreadSlab, offset, inc);
+}
+
+/* Allocates the thread slabs, aligned on THREAD_SLAB_ALIGN */
+static void init_thread_slabs(void)
+{
+  const SizeT size = VG_N_THREADS * sizeof(ThreadSlab);
+  threadSlabsBlock = VG_(malloc)("threadslabs.init", size + THREAD_SLAB_ALIGN);
+  threadSlabs = (ThreadSlab*)VG_ROUNDUP((Addr)threadSlabsBlock, THREAD_SLAB_ALIGN);
+  VG_(memset)(threadSlabs, 0, size);
+  curThreadSlab = &threadSlabs[0];
+}
+
+/* A thread starts running client code */
+static void vc_start_client_code(ThreadId tid, ULong blocks_done)
+{
+  tl_assert(tid < VG_N_THREADS);
+  if (clo_per_thread) {
+    curThreadSlab = &threadSlabs[tid];
+    curThreadSlab->seen = True;
+  }
+  if (clo_context_depth > 0) {
+    Context_SwitchThread(tid);
+  }
+  Region_SwitchThread(tid);
+}
+
+/* Counts inc in the context of the running thread */
+static void count_context(IRSB* sb, HWord offset, ULong inc)
+{
+  count_indirect(sb, (HWord*)&curCtxNode, offset, inc);
+}
+
+/* Counts inc in the region of the running thread */
+static void count_region(IRSB* sb, HWord offset, ULong inc)
+{
+  count_indirect(sb, (HWord*)&curRegion, offset, inc);
+}
+
+/* Names the pending callee, if any, at the function entry:  */
+/*   t1 = LDle:I32(&contextPending)                           */
+/*   t2 = CmpNE32(t1, 0)                                      */
+/*   if (t2) Context_Enter(entry)                             */
+static void instrument_context_entry(IRSB* sb, Addr entry)
+{
+  IRDirty* di;
+  IRTemp t1 = newIRTemp(sb->tyenv, Ity_I32);
+  IRTemp t2 = newIRTemp(sb->tyenv, Ity_I1);
+
+  addStmtToIRSB( sb, IRStmt_WrTmp(t1, IRExpr_Load(END, Ity_I32,
+						  mkIRExpr_HWord( (HWord)&contextPending ))) );
+  addStmtToIRSB( sb, IRStmt_WrTmp(t2, IRExpr_Binop(Iop_CmpNE32,
+						   IRExpr_RdTmp(t1),
+						   IRExpr_Const(IRConst_U32(0)))) );
+  di = unsafeIRDirty_0_N( 1, "Context_Enter",
+			  VG_(fnptr_to_fnentry)( &Context_Enter ),
+			  mkIRExprVec_1(mkIRExpr_HWord(entry)) );
+  di->guard = IRExpr_RdTmp(t2);
+  addStmtToIRSB( sb, IRStmt_Dirty(di) );
+}
+
+/* Adds the shadow stack update for a jump of kind jk to target */
+/* guard is NULL for the final jump of the superblock           */
+static void instrument_context_jump(IRSB* sb, IRJumpKind jk, IRExpr *target,
+				    IRExpr *guard)
+{
+  IRDirty* di;
+  switch (jk) {
+  case Ijk_Call:
+    di = unsafeIRDirty_0_N( 1, "Context_Call",
+			    VG_(fnptr_to_fnentry)( &Context_Call ),
+			    mkIRExprVec_1(target) );
+    break;
+  case Ijk_Ret:
+    di = unsafeIRDirty_0_N( 0, "Context_Ret",
+			    VG_(fnptr_to_fnentry)( &Context_Ret ),
+			    mkIRExprVec_0() );
+    break;
+  default:
+    return;
+  }
+  if (guard) {
+    di->guard = guard;
+  }
+  addStmtToIRSB( sb, IRStmt_Dirty(di) );
+}
+
 static void vc_post_clo_init(void)
 {
+  vc_checkOpTable();
   FnContainer_Init(&ieeeFNC);
   FnContainer_Init(&ifFNC);
   init_FPCounter(&ieeeFPC);
   init_FPCounter(&ifFPC);
+  if (clo_op_mix) {
+    init_FPCounter(&opMixFPC);
+  }
+  if (clo_count_bytes) {
+    init_FPCounter(&bytesFPC);
+  }
+  if (clo_granularity == GRANULARITY_CONTEXT && clo_context_depth == 0) {
+    clo_context_depth = DEFAULT_CONTEXT_DEPTH;
+  }
+  if (clo_callgrind_out) {
+    /* The profile is made of the lines of each function */
+    if (clo_granularity != GRANULARITY_FUNCTION &&
+	clo_granularity != GRANULARITY_LINE) {
+      VG_(fmsg_bad_option)("--callgrind-out=yes",
+			   "needs --granularity=function or line\n");
+    }
+    clo_granularity = GRANULARITY_LINE;
+  }
+  if (clo_granularity == GRANULARITY_LINE) {
+    LineContainer_Init(&ieeeLNC);
+  }
+  if (clo_per_thread) {
+    init_thread_slabs();
+  }
+  if (clo_context_depth > 0) {
+    init_Context(clo_context_depth);
+    /* A call chased into its callee inside a superblock has no */
+    /* Ijk_Call exit, the shadow stacks need every call to exit */
+    VG_(clo_vex_control).guest_chase = False;
+  }
+  collecting = clo_collect_atstart;
+  if (clo_sample_rate > 1) {
+    /* The increments are applied per segment */
+    clo_batch_counts = True;
+    sampleBlocks = VG_(OSetGen_Create)(offsetof(SampleBlock, addr), NULL,
+				       VG_(malloc), "sample.init", VG_(free));
+    sampleState = (ULong)clo_sample_seed ^ 0x9E3779B97F4A7C15ULL;
+  }
+  if (clo_snapshot_interval > 0) {
+    HChar *path = VG_(expand_file_name)("--snapshot-file", clo_snapshot_file);
+    snapshotOut = Output_Open(path);
+    VG_(free)(path);
+    if (snapshotOut == NULL) {
+      clo_snapshot_interval = 0;
+    } else {
+      init_FPCounter(&ieeePrevFPC);
+      init_FPCounter(&ifPrevFPC);
+      snapshotCountdown = clo_snapshot_interval;
+      Output_Printf(snapshotOut, "snapshot,position,kind,object,file,function,count\n");
+    }
+  }
+  init_Region();
+  VG_(track_start_client_code)(vc_start_client_code);
   init_ignored_libs_default();
+  init_obj_verdicts();
+  init_interflop_entries();
+  initDebugInfoCache();
+}
+
+/* Object mapped: computes its verdict once */
+static void vc_new_mem_mmap(Addr a, SizeT len, Bool rr, Bool ww, Bool xx,
+			    ULong di_handle)
+{
+  if (xx) {
+    add_obj_verdict(a, len);
+    remove_interflop_entries(a, len);
+  }
+}
+
+/* Code unmapped: its debug info must not be used anymore */
+static void vc_die_mem_munmap(Addr a, SizeT len)
+{
+  invalidateDebugInfoCache(a, len);
+  remove_obj_verdicts(a, len);
+  remove_interflop_entries(a, len);
 }
 
 /* Primitive operations that are used in Unop, Binop, Triop and Qop IRExprs.*/
 static
-Bool vc_isPrimops(IRExpr *expr) {
+Bool vc_isPrimops(const IRExpr *expr) {
   switch(expr->tag) {
   case Iex_Qop:
   case Iex_Triop:
@@ -110,7 +967,7 @@ Bool vc_isPrimops(IRExpr *expr) {
 /* Return the op assiocated to a primitive operation */
 /* Raise an error if expr is not a primitive operation */
 static
-IROp vc_getOp(IRExpr *expr) {
+IROp vc_getOp(const IRExpr *expr) {
   switch(expr->tag) {
   case Iex_Qop:
     return expr->Iex.Qop.details->op;
@@ -126,6 +983,71 @@ IROp vc_getOp(IRExpr *expr) {
   }
 }
 
+/* Returns True if the statement accesses memory */
+static
+Bool vc_isMemAccess(const IRStmt *st)
+{
+  switch (st->tag) {
+  case Ist_Store:
+  case Ist_LoadG:
+  case Ist_StoreG:
+    return True;
+  case Ist_WrTmp:
+    return st->Ist.WrTmp.data->tag == Iex_Load;
+  default:
+    return False;
+  }
+}
+
+/* Returns True if the superblock calls or returns, in its final */
+/* jump or in a side exit                                       */
+static
+Bool vc_hasCallRet(const IRSB* sbIn)
+{
+  Int i;
+  if (sbIn->jumpkind == Ijk_Call || sbIn->jumpkind == Ijk_Ret) {
+    return True;
+  }
+  for (i = 0; i < sbIn->stmts_used; i++) {
+    const IRStmt* st = sbIn->stmts[i];
+    if (st->tag == Ist_Exit &&
+	(st->Ist.Exit.jk == Ijk_Call || st->Ist.Exit.jk == Ijk_Ret)) {
+      return True;
+    }
+  }
+  return False;
+}
+
+/* Pre-scan of a superblock, before any debug info lookup       */
+/* Returns True if the superblock has FP arithmetic ops, or     */
+/* memory accesses if they are counted, and sets sbAddr to the  */
+/* address of its first IMark                                   */
+static
+Bool vc_preScan(const IRSB* sbIn, Addr *sbAddr)
+{
+  Int i;
+  Bool hasFP = False;
+  *sbAddr = 0;
+  for (i = 0; i < sbIn->stmts_used && !hasFP; i++) {
+    IRStmt* st = sbIn->stmts[i];
+    switch (st->tag) {
+    case Ist_IMark:
+      if (*sbAddr == 0) {
+	*sbAddr = st->Ist.IMark.addr;
+      }
+      break;
+    case Ist_WrTmp:
+      hasFP = vc_isPrimops(st->Ist.WrTmp.data)
+	&& vc_isArithmeticOpF(vc_getOp(st->Ist.WrTmp.data));
+      break;
+    default:
+      break;
+    }
+    hasFP |= clo_count_bytes && vc_isMemAccess(st);
+  }
+  return hasFP;
+}
+
 /* Wrapper for instrumenting an expression */
 /* Call the instrumentation with the right parameters */
 /* depending on the instrumentation type (IEEE or INTERFLOP) */
@@ -134,69 +1056,216 @@ void vc_instrumentExpr (IRSB* sb, const InstType it, const ULong funNo, const UL
 {
   switch (it) {
   case INST_IEEE:
-    instrument_detail(sb, ieeeFPC, funNo, inc);
+    count_detail(sb, addr_FPCounter(ieeeFPC, funNo), inc);
+    count_detail(sb, &ieeeTotal, inc);
+    segmentIeee += inc;
+    if (clo_per_thread) {
+      count_thread(sb, offsetof(ThreadSlab, ieee), inc);
+    }
+    if (clo_context_depth > 0) {
+      count_context(sb, offsetof(CtxNode, ieee), inc);
+    }
+    if (regionsActive) {
+      count_region(sb, offsetof(RegionNode, ieee), inc);
+    }
     break;
   case INST_INTERFLOP:
-    instrument_detail(sb, ifFPC, funNo, inc);
+    count_detail(sb, addr_FPCounter(ifFPC, funNo), inc);
+    count_detail(sb, &ifTotal, inc);
+    segmentIf += inc;
+    if (clo_per_thread) {
+      count_thread(sb, offsetof(ThreadSlab, interflop), inc);
+    }
+    if (clo_context_depth > 0) {
+      count_context(sb, offsetof(CtxNode, interflop), inc);
+    }
+    if (regionsActive) {
+      count_region(sb, offsetof(RegionNode, interflop), inc);
+    }
     break;
   default:
     VG_(tool_panic)("Unknown instrumentation type");
   }    
 }
 
-/* Return the function number associated to a debug information */
-/* Only look the function name for the moment */
-/* Could be extented to arbitrary stack trace level */
+/* Returns the counter of the cell for the function funNo in a   */
+/* FPCounter holding nbCells counters per function. The counters */
+/* of the function are allocated if needed                       */
 static
-ULong get_funNo(FnContainer *T,
-		const DebugInfo *di,
-		FPCounter *FPC)
-
+ULong* addr_cell(FPCounter *FPC, const UInt nbCells,
+		 const ULong funNo, const UInt cell)
 {
-  ULong funNo;
-  const ContainerKey key = getKey(di);
-  if (FnContainer_HasObj(T, &key)) {
-    funNo = FnContainer_ID(T, &key);
-  } else {
-    ContainerObj *obj = ContainerObj_New(T, &key, di);
-    funNo = obj->ID;
-    FnContainer_Insert(T, obj);
+  while (size_FPCounter(FPC) < (funNo + 1) * nbCells) {
     increment_FPCounter(FPC);
   }
-  return funNo;
+  return addr_FPCounter(FPC, funNo * nbCells + cell);
 }
 
-/* Checks if the debug information has a function number */
+/* FP and vector types are counted in the FP cells */
 static
-Bool has_funNo(FnContainer *T,
-	       const DebugInfo *di)
-
+Bool isFPType(const IRType ty)
 {
-  ULong funNo;
-  const ContainerKey key = getKey(di);
-  if (FnContainer_HasObj(T, &key)) {
+  switch (ty) {
+  case Ity_F16:
+  case Ity_F32:
+  case Ity_F64:
+  case Ity_F128:
+  case Ity_D32:
+  case Ity_D64:
+  case Ity_D128:
+  case Ity_V128:
+  case Ity_V256:
     return True;
-  } else {
+  default:
     return False;
   }
 }
 
-/* Wrapper that prints the StackTrace for the current tid */
+/* Returns the bytes counter of an access of type ty for funNo */
 static
-void ppST(void) {
-  VG_(get_and_pp_StackTrace)(VG_(get_running_tid)(), 256);
+ULong* addr_bytes(const ULong funNo, const IRType ty, const Bool isStore)
+{
+  const UInt cell = (isFPType(ty))
+    ? ((isStore) ? BYTES_FP_STORE : BYTES_FP_LOAD)
+    : ((isStore) ? BYTES_INT_STORE : BYTES_INT_LOAD);
+  return addr_cell(bytesFPC, BYTES_NB_CELLS, funNo, cell);
 }
 
-
-/* Instrumentation */
-/* Three cases: */
+/* Counts the bytes loaded or stored by st for funNo */
+static
+void vc_instrumentMemAccess(IRSB* sb, const IRTypeEnv* tyenv,
+			    const IRStmt *st, const ULong funNo)
+{
+  IRType ty, tyArg;
+  switch (st->tag) {
+  case Ist_Store:
+    ty = typeOfIRExpr(tyenv, st->Ist.Store.data);
+    count_detail(sb, addr_bytes(funNo, ty, True), sizeofIRType(ty));
+    break;
+  case Ist_WrTmp:
+    ty = st->Ist.WrTmp.data->Iex.Load.ty;
+    count_detail(sb, addr_bytes(funNo, ty, False), sizeofIRType(ty));
+    break;
+  case Ist_LoadG:
+    /* tyArg is the type read from memory */
+    typeOfIRLoadGOp(st->Ist.LoadG.details->cvt, &ty, &tyArg);
+    instrument_detail_guarded(sb, addr_bytes(funNo, tyArg, False),
+			      sizeofIRType(tyArg), st->Ist.LoadG.details->guard);
+    break;
+  case Ist_StoreG:
+    ty = typeOfIRExpr(tyenv, st->Ist.StoreG.details->data);
+    instrument_detail_guarded(sb, addr_bytes(funNo, ty, True),
+			      sizeofIRType(ty), st->Ist.StoreG.details->guard);
+    break;
+  default:
+    VG_(tool_panic)("Not a memory access");
+  }
+}
+
+/* Returns the line object of the instruction at addr */
+/* for the IEEE function funNo                        */
+static
+LineObj* get_line(const ULong funNo, const Addr addr)
+{
+  LineKey key;
+  key.funNo = funNo;
+  getLineAt(addr, &key.file, &key.line);
+  key.addr = (clo_line_addrs) ? addr : 0;
+  return LineContainer_Get(ieeeLNC, &key);
+}
+
+/* Return the function number associated to a debug information */
+/* Only look the function name for the moment */
+/* Could be extented to arbitrary stack trace level */
+static
+ULong get_funNo(FnContainer *T,
+		const DebugInfo *di,
+		FPCounter *FPC)
+
+{
+  const ContainerKey key = getKey(di);
+  ContainerObj *obj = FnContainer_Lookup(T, &key);
+  if (obj == NULL) {
+    obj = ContainerObj_New(T, &key, di);
+    FnContainer_Insert(T, obj);
+    increment_FPCounter(FPC);
+  }
+  return obj->ID;
+}
+
+/* Debug info of the aggregated counters of --granularity=total */
+/* and object, the object name and the symbol ID are set by      */
+/* get_counterNo                                                 */
+static const DebugInfo totalDebugInfo = {
+  .lib = "*",
+  .dir = "*",
+  .file = "*",
+  .function = "*",
+  .line = 0,
+  .isEntry = False,
+  .entry = 0,
+  .symId = UNK_SYMID
+};
+
+/* Checks if addr is one of the nbEntries Interflop entries */
+static
+Bool vc_isInterflopEntry(const Addr *entries, UInt nbEntries, Addr addr)
+{
+  UInt i;
+  for (i = 0; i < nbEntries; i++) {
+    if (entries[i] == addr) {
+      return True;
+    }
+  }
+  return False;
+}
+
+/* Returns the number of the counter charged for di, depending on */
+/* --granularity: the single total counter, the counter of its    */
+/* object or the counter of its function                          */
+static
+ULong get_counterNo(FnContainer *T,
+		    const DebugInfo *di,
+		    FPCounter *FPC)
+{
+  DebugInfo objDebugInfo;
+
+  switch (clo_granularity) {
+  case GRANULARITY_TOTAL:
+    /* No lookup, the counter is created once */
+    if (FnContainer_Size(T) == 0) {
+      objDebugInfo = totalDebugInfo;
+      objDebugInfo.symId = getAggregateSymId(totalDebugInfo.lib);
+      get_funNo(T, &objDebugInfo, FPC);
+    }
+    return 0;
+  case GRANULARITY_OBJECT:
+    /* Objects are keyed by the symbol of their aggregated counter */
+    objDebugInfo = totalDebugInfo;
+    objDebugInfo.lib = di->lib;
+    objDebugInfo.symId = getAggregateSymId(di->lib);
+    return get_funNo(T, &objDebugInfo, FPC);
+  default:
+    return get_funNo(T, di, FPC);
+  }
+}
+
+/* Wrapper that prints the StackTrace for the current tid */
+static
+void ppST(void) {
+  VG_(get_and_pp_StackTrace)(VG_(get_running_tid)(), 256);
+}
+
+
+/* Instrumentation */
+/* Three cases: */
 /* - INST_IGNORE    : the statement is ignored */
 /* - INST_IEEE      : the function does not belong to interflop. */
 /*                    so each FP operations is instrumented. */
 /*                    The instrumentation increments the FPCounter */
 /*                    by the size of the operand (scalar or vector) */
 /* - INST_INTERFLOP : the function belongs to interflop */
-/*                    We only instrument the top-level function */
+/*                    We only instrument the entry of the function */
 /*                    and not the FP themselves. Hence, _interflop_add_float */
 /*		      counts as one FP operation no matter how many real FP */
 /*                    are executed.
@@ -211,36 +1280,138 @@ IRSB* vc_instrument ( VgCallbackClosure* closure,
 {
 
   UInt i;
-  IRSB* sbOut = deepCopyIRSBExceptStmts(sbIn);
+  Addr sbAddr = 0;
+
+  /* Only superblocks with FP operations, or with an extent starting */
+  /* at a function entry that may be an interflop call, need the     */
+  /* debug info and the exclusion lists. The others are left         */
+  /* untouched, except for calls and returns that drive the shadow   */
+  /* stacks of the contexts in any code, ignored or not, and even    */
+  /* while the collection is stopped.                                */
+  if (!collecting && clo_context_depth == 0) {
+    return sbIn;
+  }
+
+  const Bool hasFP = collecting && vc_preScan(sbIn, &sbAddr);
+  const Bool trackCalls = (clo_context_depth > 0) && vc_hasCallRet(sbIn);
+  /* Function entries name the callees called through a stub, */
+  /* chasing is disabled so the entry can only be the start   */
+  const Bool trackEntry = (clo_context_depth > 0) &&
+    Context_IsCalleeEntry(vge->base[0]);
+  /* Guest instructions are counted everywhere for the snapshots */
+  const Bool countInstrs = collecting && (clo_snapshot_interval > 0) &&
+    (clo_snapshot_unit == SNAPSHOT_UNIT_INSTRS);
+  const DebugInfo *di = NULL;
+  const DebugInfo *di_entry = NULL;
+  InstType instType = INST_IGNORE;
+
+  /* Interflop entries of the superblock. A call enters a function */
+  /* at its entry, which starts a superblock or one of its chased  */
+  /* extents, so every extent is checked, and an increment at the  */
+  /* IMark of each such entry counts every call once, in every     */
+  /* translation that runs it.                                     */
+  Addr ifEntries[sizeof(vge->base) / sizeof(vge->base[0])];
+  UInt nbIfEntries = 0;
+  for (i = 0; i < vge->n_used && collecting; i++) {
+    if (is_interflop_entry(vge->base[i])) {
+      ifEntries[nbIfEntries++] = vge->base[i];
+    }
+  }
+
+  /* The entries are counted on their own, the debug info of the */
+  /* superblock is only needed for its FP operations             */
+  if (hasFP) {
+    di = getDebugInfoAt(sbAddr);
+    instType = get_InstType(di);
+  }
+
+  if (instType == INST_IGNORE && !trackCalls && !trackEntry && !countInstrs &&
+      nbIfEntries == 0) {
+    return sbIn;
+  }
 
-  const DebugInfo *di = getDebugInfo();
-  DebugInfo *di_st = NULL;
-  
   ULong funNo, sizeType;
   IROp op;
-  InstType instType = get_InstType(di);
+
+  IRSB* sbOut = deepCopyIRSBExceptStmts(sbIn);
+  nbPendingIncs = 0;
+  segmentCost = 0;
+  segmentIeee = segmentIf = 0;
+  sampleGuard = IRTemp_INVALID;
+  /* Sampled superblocks get their countdown at the first IMark */
+  Bool sampled = (clo_sample_rate > 1) &&
+    (instType != INST_IGNORE || countInstrs || nbIfEntries > 0);
+  if (sampled) {
+    curSampleBlock = get_sample_block(closure->nraddr);
+  }
+  /* Function number of the superblock, resolved at the */
+  /* first counted statement and reused for the next ones */
+  Bool hasFunNo = False;
+  /* Address of the current instruction and its line object, */
+  /* resolved at its first FP statement                      */
+  Addr imarkAddr = sbAddr;
+  LineObj *lineObj = NULL;
   
   /*Loop over instructions*/
   for (i = 0 ; i < sbIn->stmts_used ; i++) {
     IRStmt* st = sbIn->stmts[i];    
+    if ((instType == INST_IEEE) && clo_count_bytes && vc_isMemAccess(st)) {
+      if (!hasFunNo) {
+	funNo = get_counterNo(ieeeFNC, di, ieeeFPC);
+	hasFunNo = True;
+      }
+      vc_instrumentMemAccess(sbOut, sbIn->tyenv, st, funNo);
+    }
     switch (st->tag) {
     case Ist_IMark:
-      if (instType == INST_INTERFLOP) {
-	di_st = getDebugInfoAt(st->Ist.IMark.addr);
-	if (di_st->isEntry && !has_funNo(ifFNC, di)) {
-	  funNo = get_funNo(ifFNC, di, ifFPC);
-	  vc_instrumentExpr(sbOut, instType, funNo, 1);
-	}
+      imarkAddr = st->Ist.IMark.addr;
+      lineObj = NULL;
+      if (countInstrs) {
+	count_snapshot(SNAPSHOT_UNIT_INSTRS, 1);
       }
       addStmtToIRSB(sbOut, sbIn->stmts[i]);
+      if (trackEntry && imarkAddr == vge->base[0]) {
+	instrument_context_entry(sbOut, imarkAddr);
+      }
+      if (sampled && sampleGuard == IRTemp_INVALID) {
+	instrument_sample_countdown(sbOut);
+      }
+      if (vc_isInterflopEntry(ifEntries, nbIfEntries, imarkAddr)) {
+	di_entry = getDebugInfoAt(imarkAddr);
+	vc_instrumentExpr(sbOut, INST_INTERFLOP,
+			  get_counterNo(ifFNC, di_entry, ifFPC), 1);
+	count_snapshot(SNAPSHOT_UNIT_FP, 1);
+      }
       break;
     case Ist_WrTmp:
       if ((instType == INST_IEEE) && vc_isPrimops(st->Ist.WrTmp.data)) {	
 	op = vc_getOp(st->Ist.WrTmp.data);
 	if (vc_isArithmeticOpF(op)) {
-	  funNo = get_funNo(ieeeFNC, di, ieeeFPC);
-	  sizeType = vc_getSizeArithmeticOp(op);
+	  if (!hasFunNo) {
+	    funNo = get_counterNo(ieeeFNC, di, ieeeFPC);
+	    hasFunNo = True;
+	  }
+	  sizeType = (clo_flop_model == FLOP_MODEL_FLOPS)
+	    ? vc_getFlopsArithmeticOp(op)
+	    : vc_getSizeArithmeticOp(op);
 	  vc_instrumentExpr(sbOut, instType, funNo, sizeType);
+	  count_snapshot(SNAPSHOT_UNIT_FP, sizeType);
+	  if (clo_granularity == GRANULARITY_LINE) {
+	    if (lineObj == NULL) {
+	      lineObj = get_line(funNo, imarkAddr);
+	    }
+	    count_detail(sbOut, &lineObj->count, sizeType);
+	    if (clo_callgrind_out) {
+	      count_detail(sbOut,
+			   &lineObj->flops[(vc_getOpDesc(op)->precision == 32) ? 0 : 1],
+			   vc_getFlopsArithmeticOp(op));
+	    }
+	  }
+	  if (clo_op_mix) {
+	    count_detail(sbOut, addr_cell(opMixFPC, OPMIX_NB_CELLS, funNo,
+					     vc_getOpMixCell(op)),
+		       sizeType);
+	  }
 	}
       }
       addStmtToIRSB(sbOut, sbIn->stmts[i]);
@@ -249,6 +1420,13 @@ IRSB* vc_instrument ( VgCallbackClosure* closure,
       addStmtToIRSB(sbOut, sbIn->stmts[i]);
       break;
     case Ist_Exit:
+      /* Closes the current segment */
+      flush_segment(sbOut);
+      if (trackCalls) {
+	instrument_context_jump(sbOut, st->Ist.Exit.jk,
+				IRExpr_Const(st->Ist.Exit.dst),
+				st->Ist.Exit.guard);
+      }
       addStmtToIRSB(sbOut, sbIn->stmts[i]);
       break;
     default:
@@ -256,6 +1434,12 @@ IRSB* vc_instrument ( VgCallbackClosure* closure,
     }
   }
 
+  /* Last segment, ends with the final jump */
+  flush_segment(sbOut);
+  if (trackCalls) {
+    instrument_context_jump(sbOut, sbIn->jumpkind, sbIn->next, NULL);
+  }
+
   return sbOut;
 }
 
@@ -270,41 +1454,605 @@ static ULong countFP(FnContainer *FNC, FPCounter *FPC) {
 
   ContainerObj *it = NULL;
   while ( (it = FnContainer_Next(FNC)) ) {
-    nb_fp_total += FPC->data[it->ID];
+    nb_fp_total += get_FPCounter(FPC, it->ID);
   }  
   return nb_fp_total;
 }
 
 /* Pretty printer for fp counter */
+/* With --granularity=total, only the total is printed by the caller */
 static void ppFP(const HChar *name, FnContainer *FNC, FPCounter *FPC) {
   Word size_FNC = FnContainer_Size(FNC);
   tl_assert(size_FNC == FPC->size);
-  VG_(umsg)("%llu %s functions visited\n", FPC->size, name);
+  if (clo_granularity == GRANULARITY_TOTAL) {
+    return;
+  }
+  VG_(umsg)("%llu %s %s visited\n", FPC->size, name,
+	    (clo_granularity == GRANULARITY_OBJECT) ? "objects" : "functions");
   VG_(umsg)("-------------------------\n");
 
   FnContainer_ResetIterator(FNC);
 
   ContainerObj *it = NULL;
   while ( (it = FnContainer_Next(FNC)) ) {
-    VG_(umsg)("\t* %s -> %s : %llu\n", it->libName, it->key, FPC->data[it->ID]);
+    if (clo_granularity == GRANULARITY_OBJECT) {
+      VG_(umsg)("\t* %s : %llu\n", it->libName, get_FPCounter(FPC, it->ID));
+    } else {
+      VG_(umsg)("\t* %s -> %s : %llu\n", it->libName, it->name, get_FPCounter(FPC, it->ID));
+    }
   }
 }
 
-static void vc_fini(Int exitcode)
+/* Prints the non-null op-mix cells of counts */
+static void ppOpMixCells(const ULong *counts) {
+  UInt cell;
+  HChar name[OPMIX_NAME_SIZE];
+  for (cell = 0; cell < OPMIX_NB_CELLS; cell++) {
+    if (counts[cell] > 0) {
+      vc_getOpMixCellName(cell, name);
+      VG_(umsg)("\t\t%s : %llu\n", name, counts[cell]);
+    }
+  }
+}
+
+/* Pretty printer for the op-mix counter */
+static void ppOpMix(FnContainer *FNC) {
+  UInt cell;
+  ULong counts[OPMIX_NB_CELLS];
+  ULong total[OPMIX_NB_CELLS];
+  const ULong nbFuns = size_FPCounter(opMixFPC) / OPMIX_NB_CELLS;
+
+  VG_(umsg)("IEEE op-mix\n");
+  VG_(umsg)("-------------------------\n");
+  VG_(memset)(total, 0, sizeof(total));
+
+  FnContainer_ResetIterator(FNC);
+
+  ContainerObj *it = NULL;
+  while ( (it = FnContainer_Next(FNC)) ) {
+    /* Functions without FP arithmetic have no op-mix counters */
+    if (it->ID >= nbFuns) {
+      continue;
+    }
+    for (cell = 0; cell < OPMIX_NB_CELLS; cell++) {
+      counts[cell] = get_FPCounter(opMixFPC, it->ID * OPMIX_NB_CELLS + cell);
+      total[cell] += counts[cell];
+    }
+    VG_(umsg)("\t* %s -> %s\n", it->libName, it->name);
+    ppOpMixCells(counts);
+  }
+  VG_(umsg)("-------------------------\n");
+  VG_(umsg)("\t* Total\n");
+  ppOpMixCells(total);
+  VG_(umsg)("\n");
+}
+
+/* Pretty printer for the bytes counter                      */
+/* FLOPs per byte is the FP count of the function divided by */
+/* all the bytes it loads and stores                         */
+static void ppBytes(FnContainer *FNC, FPCounter *FPC) {
+  UInt cell;
+  ULong counts[BYTES_NB_CELLS];
+  ULong total[BYTES_NB_CELLS];
+  ULong fp, bytes, totalFP = 0, totalBytes = 0;
+  const ULong nbFuns = size_FPCounter(bytesFPC) / BYTES_NB_CELLS;
+
+  VG_(umsg)("IEEE load/store bytes (fp load, fp store, int load, int store)\n");
+  VG_(umsg)("-------------------------\n");
+  VG_(memset)(total, 0, sizeof(total));
+
+  FnContainer_ResetIterator(FNC);
+
+  ContainerObj *it = NULL;
+  while ( (it = FnContainer_Next(FNC)) ) {
+    /* Functions without memory accesses have no bytes counters */
+    if (it->ID >= nbFuns) {
+      continue;
+    }
+    bytes = 0;
+    for (cell = 0; cell < BYTES_NB_CELLS; cell++) {
+      counts[cell] = get_FPCounter(bytesFPC, it->ID * BYTES_NB_CELLS + cell);
+      total[cell] += counts[cell];
+      bytes += counts[cell];
+    }
+    fp = get_FPCounter(FPC, it->ID);
+    totalFP += fp;
+    totalBytes += bytes;
+    VG_(umsg)("\t* %s -> %s : %llu %llu %llu %llu", it->libName, it->name,
+	      counts[BYTES_FP_LOAD], counts[BYTES_FP_STORE],
+	      counts[BYTES_INT_LOAD], counts[BYTES_INT_STORE]);
+    if (bytes > 0) {
+      VG_(umsg)(" : %.3f FP/byte\n", (Double)fp / bytes);
+    } else {
+      VG_(umsg)("\n");
+    }
+  }
+  VG_(umsg)("-------------------------\n");
+  VG_(umsg)("Total: %llu %llu %llu %llu", total[BYTES_FP_LOAD],
+	    total[BYTES_FP_STORE], total[BYTES_INT_LOAD], total[BYTES_INT_STORE]);
+  if (totalBytes > 0) {
+    VG_(umsg)(" : %.3f FP/byte\n\n", (Double)totalFP / totalBytes);
+  } else {
+    VG_(umsg)("\n\n");
+  }
+}
+
+/* Pretty printer for the per-thread counters                  */
+/* The imbalance is the maximum over the mean of the FP count  */
+/* of the threads that executed FP operations (1 is balanced)  */
+static void ppThreads(void) {
+  ThreadId tid;
+  ULong fp, maxFP = 0, sumFP = 0, nbThreads = 0;
+
+  VG_(umsg)("Per-thread FP (IEEE, Interflop)\n");
+  VG_(umsg)("-------------------------\n");
+  for (tid = 1; tid < VG_N_THREADS; tid++) {
+    const ThreadSlab *slab = &threadSlabs[tid];
+    if (!slab->seen) {
+      continue;
+    }
+    fp = slab->ieee + slab->interflop;
+    VG_(umsg)("\t* thread %u : %llu %llu\n", tid, slab->ieee, slab->interflop);
+    if (fp > 0) {
+      maxFP = (fp > maxFP) ? fp : maxFP;
+      sumFP += fp;
+      nbThreads++;
+    }
+  }
+  VG_(umsg)("-------------------------\n");
+  if (nbThreads > 0) {
+    VG_(umsg)("Thread imbalance (max/mean): %.3f over %llu threads\n\n",
+	      (Double)maxFP * nbThreads / sumFP, nbThreads);
+  } else {
+    VG_(umsg)("Thread imbalance: no FP operations\n\n");
+  }
+}
+
+static Int cmpFuncLine_LineObj(const void* a, const void* b) {
+  const LineObj* x = *(LineObj* const*)a;
+  const LineObj* y = *(LineObj* const*)b;
+  Int c;
+  if (x->key.funNo != y->key.funNo) {
+    return (x->key.funNo < y->key.funNo) ? -1 : 1;
+  }
+  if (x->key.file != y->key.file) {
+    c = VG_(strcmp)(x->key.file, y->key.file);
+    if (c != 0) {
+      return c;
+    }
+  }
+  if (x->key.line != y->key.line) {
+    return (x->key.line < y->key.line) ? -1 : 1;
+  }
+  return (x->key.addr < y->key.addr) ? -1 : (x->key.addr > y->key.addr);
+}
+
+static Int cmpCount_ContainerObj(const void* a, const void* b) {
+  const ULong x = get_FPCounter(ieeeFPC, (*(ContainerObj* const*)a)->ID);
+  const ULong y = get_FPCounter(ieeeFPC, (*(ContainerObj* const*)b)->ID);
+  return (x > y) ? -1 : (x < y) ? 1 : 0;
+}
+
+/* Pretty printer for the line counter                        */
+/* The lines of the LINE_REPORT_FUNCTIONS hottest functions   */
+/* are printed in source order                                */
+static void ppLines(FnContainer *FNC, LineContainer *LNC) {
+  ULong i, first, nbFuns = 0;
+  const ULong nbLines = LineContainer_Size(LNC);
+  ContainerObj **funs = VG_(malloc)("ppLines.funs",
+				    (FnContainer_Size(FNC) + 1) * sizeof(ContainerObj*));
+  LineObj **lines = VG_(malloc)("ppLines.lines", (nbLines + 1) * sizeof(LineObj*));
+  /* First line of each function in lines */
+  ULong *firstLine = VG_(malloc)("ppLines.first",
+				 (FnContainer_Size(FNC) + 1) * sizeof(ULong));
+
+  FnContainer_ResetIterator(FNC);
+  ContainerObj *it = NULL;
+  while ( (it = FnContainer_Next(FNC)) ) {
+    funs[nbFuns++] = it;
+    firstLine[it->ID] = nbLines;
+  }
+  VG_(ssort)(funs, nbFuns, sizeof(ContainerObj*), cmpCount_ContainerObj);
+
+  for (i = 0; i < nbLines; i++) {
+    lines[i] = LineContainer_At(LNC, i);
+  }
+  VG_(ssort)(lines, nbLines, sizeof(LineObj*), cmpFuncLine_LineObj);
+  for (i = nbLines; i > 0; i--) {
+    firstLine[lines[i - 1]->key.funNo] = i - 1;
+  }
+
+  VG_(umsg)("IEEE FP per line of the %llu hottest functions\n",
+	    (nbFuns < LINE_REPORT_FUNCTIONS) ? nbFuns : LINE_REPORT_FUNCTIONS);
+  VG_(umsg)("-------------------------\n");
+  for (i = 0; i < nbFuns && i < LINE_REPORT_FUNCTIONS; i++) {
+    const ULong funNo = funs[i]->ID;
+    if (get_FPCounter(ieeeFPC, funNo) == 0) {
+      break;
+    }
+    VG_(umsg)("\t* %s -> %s : %llu\n", funs[i]->libName, funs[i]->name,
+	      get_FPCounter(ieeeFPC, funNo));
+    for (first = firstLine[funNo];
+	 first < nbLines && lines[first]->key.funNo == funNo; first++) {
+      const LineObj *line = lines[first];
+      if (line->count == 0) {
+	continue;
+      }
+      if (clo_line_addrs) {
+	VG_(umsg)("\t\t%s:%u 0x%lx : %llu\n", line->key.file, line->key.line,
+		  line->key.addr, line->count);
+      } else {
+	VG_(umsg)("\t\t%s:%u : %llu\n", line->key.file, line->key.line,
+		  line->count);
+      }
+    }
+  }
+  VG_(umsg)("-------------------------\n\n");
+
+  VG_(free)(firstLine);
+  VG_(free)(lines);
+  VG_(free)(funs);
+}
+
+/* Expands the name of a profile file given to option        */
+/* The files of a VERICHECK_DUMP are suffixed by its number   */
+/* (dumpNo), dumpNo is -1 at the end of the execution         */
+static HChar* profile_path(const HChar *option, const HChar *name,
+			   Int dumpNo) {
+  HChar *path = VG_(expand_file_name)(option, name);
+  HChar *dumpPath;
+
+  if (dumpNo < 0) {
+    return path;
+  }
+  dumpPath = VG_(malloc)("profile.path", VG_(strlen)(path) + 16);
+  VG_(sprintf)(dumpPath, "%s.%d", path, dumpNo);
+  VG_(free)(path);
+  return dumpPath;
+}
+
+/* Writes the profile in callgrind format                         */
+/* IEEE FP operations are given per line, Interflop calls at the  */
+/* entry line of the Interflop function                           */
+static void dump_callgrind(FnContainer *FNC, LineContainer *LNC,
+			   const HChar *label, Int dumpNo) {
+  ULong i, totals[4] = {0, 0, 0, 0};
+  Word j;
+  const HChar *file = NULL;
+  const ULong nbLines = LineContainer_Size(LNC);
+  ContainerObj **objs = VG_(malloc)("callgrind.objs",
+				    (FnContainer_Size(FNC) + 1) * sizeof(ContainerObj*));
+  LineObj **lines = VG_(malloc)("callgrind.lines", (nbLines + 1) * sizeof(LineObj*));
+  HChar *path = profile_path("--callgrind-out-file", clo_callgrind_out_file,
+			     dumpNo);
+  Output *out = Output_Open(path);
+
+  if (out == NULL) {
+    VG_(free)(path);
+    VG_(free)(lines);
+    VG_(free)(objs);
+    return;
+  }
+
+  Output_Printf(out, "# callgrind format\n");
+  Output_Printf(out, "version: 1\n");
+  Output_Printf(out, "creator: vericheck\n");
+  Output_Printf(out, "pid: %d\n", VG_(getpid)());
+  Output_Printf(out, "cmd: %s", VG_(args_the_exename));
+  for (j = 0; j < VG_(sizeXA)(VG_(args_for_client)); j++) {
+    Output_Printf(out, " %s", *(HChar**)VG_(indexXA)(VG_(args_for_client), j));
+  }
+  Output_Printf(out, "\npart: 1\n");
+  if (label) {
+    Output_Printf(out, "desc: Trigger: Client Request: %s\n", label);
+  }
+  Output_Printf(out, "\n");
+  Output_Printf(out, "positions: line\n");
+  Output_Printf(out, "event: IeeeFP : IEEE FP (%s)\n",
+		(clo_flop_model == FLOP_MODEL_FLOPS) ? "FLOPs" : "lanes");
+  Output_Printf(out, "event: InterflopFP : Interflop calls\n");
+  Output_Printf(out, "event: FlopsB32 : binary32 FLOPs\n");
+  Output_Printf(out, "event: FlopsB64 : binary64 FLOPs\n");
+  Output_Printf(out, "events: IeeeFP InterflopFP FlopsB32 FlopsB64\n\n");
+
+  /* The functions are indexed by ID to find them from the lines */
+  FnContainer_ResetIterator(FNC);
+  ContainerObj *it = NULL;
+  while ( (it = FnContainer_Next(FNC)) ) {
+    objs[it->ID] = it;
+  }
+
+  /* IEEE lines, grouped by function in source order */
+  for (i = 0; i < nbLines; i++) {
+    lines[i] = LineContainer_At(LNC, i);
+  }
+  VG_(ssort)(lines, nbLines, sizeof(LineObj*), cmpFuncLine_LineObj);
+  for (i = 0; i < nbLines; i++) {
+    const LineObj *line = lines[i];
+    if (line->count == 0) {
+      continue;
+    }
+    if (i == 0 || line->key.funNo != lines[i - 1]->key.funNo) {
+      const ContainerObj *obj = objs[line->key.funNo];
+      Output_Printf(out, "\n");
+      Output_Name(out, OUTPUT_NS_OBJ, "ob", obj->libName);
+      Output_Name(out, OUTPUT_NS_FILE, "fl", obj->fileName);
+      Output_Name(out, OUTPUT_NS_FN, "fn", obj->functionName);
+      file = obj->fileName;
+    }
+    /* Inlined code of another file */
+    if (line->key.file != file) {
+      Output_Name(out, OUTPUT_NS_FILE, "fi", line->key.file);
+      file = line->key.file;
+    }
+    Output_Printf(out, "%u %llu 0 %llu %llu\n", line->key.line, line->count,
+		  line->flops[0], line->flops[1]);
+    totals[0] += line->count;
+    totals[2] += line->flops[0];
+    totals[3] += line->flops[1];
+  }
+
+  /* Interflop functions */
+  FnContainer_ResetIterator(ifFNC);
+  while ( (it = FnContainer_Next(ifFNC)) ) {
+    const ULong count = get_FPCounter(ifFPC, it->ID);
+    if (count == 0) {
+      continue;
+    }
+    Output_Printf(out, "\n");
+    Output_Name(out, OUTPUT_NS_OBJ, "ob", it->libName);
+    Output_Name(out, OUTPUT_NS_FILE, "fl", it->fileName);
+    Output_Name(out, OUTPUT_NS_FN, "fn", it->functionName);
+    Output_Printf(out, "%u 0 %llu 0 0\n", it->line, count);
+    totals[1] += count;
+  }
+
+  Output_Printf(out, "\ntotals: %llu %llu %llu %llu\n",
+		totals[0], totals[1], totals[2], totals[3]);
+  Output_Close(&out);
+  VG_(umsg)("Callgrind profile written to %s\n", path);
+
+  VG_(free)(path);
+  VG_(free)(lines);
+  VG_(free)(objs);
+}
+
+static const HChar *bytesCellNames[BYTES_NB_CELLS] = {"fp_load", "fp_store",
+							"int_load", "int_store"};
+
+/* Writes the CSV header */
+static void dump_csv_header(Output *out) {
+  UInt cell;
+  HChar name[OPMIX_NAME_SIZE];
+
+  Output_Printf(out, "kind,object,dir,file,function,line,count");
+  if (clo_op_mix) {
+    for (cell = 0; cell < OPMIX_NB_CELLS; cell++) {
+      vc_getOpMixCellName(cell, name);
+      Output_Printf(out, ",%s", name);
+    }
+  }
+  if (clo_count_bytes) {
+    for (cell = 0; cell < BYTES_NB_CELLS; cell++) {
+      Output_Printf(out, ",%s", bytesCellNames[cell]);
+    }
+  }
+  Output_Printf(out, "\n");
+}
+
+/* Returns the counter of a cell, 0 if the function has no counters */
+static ULong get_cell(const FPCounter *FPC, const UInt nbCells,
+		      const ULong funNo, const UInt cell) {
+  if ((funNo + 1) * nbCells > size_FPCounter(FPC)) {
+    return 0;
+  }
+  return get_FPCounter(FPC, funNo * nbCells + cell);
+}
+
+/* Writes the record of a function                          */
+/* The op-mix and bytes cells only exist for IEEE functions */
+static void dump_function(Output *out, const ContainerObj *obj,
+			  const Bool isIEEE, const ULong count,
+			  const Bool first) {
+  UInt cell;
+  HChar name[OPMIX_NAME_SIZE];
+  Bool firstCell;
+
+  if (clo_vc_out_format == OUT_FORMAT_CSV) {
+    Output_Printf(out, "%s,", (isIEEE) ? "ieee" : "interflop");
+    Output_CSVString(out, obj->libName);
+    Output_Printf(out, ",");
+    Output_CSVString(out, obj->dirName);
+    Output_Printf(out, ",");
+    Output_CSVString(out, obj->fileName);
+    Output_Printf(out, ",");
+    Output_CSVString(out, obj->functionName);
+    Output_Printf(out, ",%u,%llu", obj->line, count);
+    if (clo_op_mix) {
+      for (cell = 0; cell < OPMIX_NB_CELLS; cell++) {
+	Output_Printf(out, ",%llu", (isIEEE)
+		      ? get_cell(opMixFPC, OPMIX_NB_CELLS, obj->ID, cell) : 0);
+      }
+    }
+    if (clo_count_bytes) {
+      for (cell = 0; cell < BYTES_NB_CELLS; cell++) {
+	Output_Printf(out, ",%llu", (isIEEE)
+		      ? get_cell(bytesFPC, BYTES_NB_CELLS, obj->ID, cell) : 0);
+      }
+    }
+    Output_Printf(out, "\n");
+    return;
+  }
+
+  Output_Printf(out, "%s\n    {\"kind\": \"%s\", \"object\": ", (first) ? "" : ",",
+		(isIEEE) ? "ieee" : "interflop");
+  Output_JSONString(out, obj->libName);
+  Output_Printf(out, ", \"dir\": ");
+  Output_JSONString(out, obj->dirName);
+  Output_Printf(out, ", \"file\": ");
+  Output_JSONString(out, obj->fileName);
+  Output_Printf(out, ", \"function\": ");
+  Output_JSONString(out, obj->functionName);
+  Output_Printf(out, ", \"line\": %u, \"count\": %llu", obj->line, count);
+  if (clo_op_mix && isIEEE) {
+    /* Null cells are omitted */
+    Output_Printf(out, ", \"op_mix\": {");
+    firstCell = True;
+    for (cell = 0; cell < OPMIX_NB_CELLS; cell++) {
+      const ULong n = get_cell(opMixFPC, OPMIX_NB_CELLS, obj->ID, cell);
+      if (n > 0) {
+	vc_getOpMixCellName(cell, name);
+	Output_Printf(out, "%s\"%s\": %llu", (firstCell) ? "" : ", ", name, n);
+	firstCell = False;
+      }
+    }
+    Output_Printf(out, "}");
+  }
+  if (clo_count_bytes && isIEEE) {
+    Output_Printf(out, ", \"bytes\": {");
+    for (cell = 0; cell < BYTES_NB_CELLS; cell++) {
+      Output_Printf(out, "%s\"%s\": %llu", (cell == 0) ? "" : ", ",
+		    bytesCellNames[cell],
+		    get_cell(bytesFPC, BYTES_NB_CELLS, obj->ID, cell));
+    }
+    Output_Printf(out, "}");
+  }
+  Output_Printf(out, "}");
+}
+
+/* Writes one record per function in JSON or CSV, */
+/* straight from the containers                   */
+static void dump_profile(ULong ieeeFP, ULong ifFP, const HChar *label,
+			 Int dumpNo) {
+  ContainerObj *it = NULL;
+  Bool first = True;
+  HChar *path = profile_path("--vc-out-file", clo_vc_out_file, dumpNo);
+  Output *out = Output_Open(path);
+
+  if (out == NULL) {
+    VG_(free)(path);
+    return;
+  }
+
+  if (clo_vc_out_format == OUT_FORMAT_CSV) {
+    dump_csv_header(out);
+  } else {
+    Output_Printf(out, "{\n  \"tool\": \"vericheck\",\n");
+    Output_Printf(out, "  \"pid\": %d,\n", VG_(getpid)());
+    if (label) {
+      Output_Printf(out, "  \"label\": ");
+      Output_JSONString(out, label);
+      Output_Printf(out, ",\n");
+    }
+    Output_Printf(out, "  \"flop_model\": \"%s\",\n",
+		  (clo_flop_model == FLOP_MODEL_FLOPS) ? "flops" : "instructions");
+    Output_Printf(out, "  \"totals\": {\"ieee\": %llu, \"interflop\": %llu},\n",
+		  ieeeFP, ifFP);
+    Output_Printf(out, "  \"functions\": [");
+  }
+
+  FnContainer_ResetIterator(ieeeFNC);
+  while ( (it = FnContainer_Next(ieeeFNC)) ) {
+    dump_function(out, it, True, get_FPCounter(ieeeFPC, it->ID), first);
+    first = False;
+  }
+  FnContainer_ResetIterator(ifFNC);
+  while ( (it = FnContainer_Next(ifFNC)) ) {
+    dump_function(out, it, False, get_FPCounter(ifFPC, it->ID), first);
+    first = False;
+  }
+
+  if (clo_vc_out_format == OUT_FORMAT_JSON) {
+    Output_Printf(out, "\n  ]\n}\n");
+  }
+  Output_Close(&out);
+  VG_(umsg)("Profile written to %s\n", path);
+  VG_(free)(path);
+}
+
+/* Square root by Newton's method, the tool has no libm */
+static Double sqrt_newton(Double x)
+{
+  Double r = (x > 1.0) ? x : 1.0;
+  UInt i;
+  if (x <= 0.0) {
+    return 0.0;
+  }
+  for (i = 0; i < 128; i++) {
+    const Double next = 0.5 * (r + x / r);
+    if (next >= r) {
+      break;
+    }
+    r = next;
+  }
+  return r;
+}
+
+/* Prints the sampled totals with their 95% confidence intervals */
+/* Each sampled segment is taken as an independent draw of       */
+/* probability 1/N, so the variance of a total is estimated by   */
+/* N(N-1) times the sum of the squared sampled costs, the sums   */
+/* of squares being already scaled by N                          */
+static void ppSampling(ULong ieeeFP, ULong ifFP)
+{
+  const Double n = (Double)clo_sample_rate;
+  const ULong ieeeCI = (ULong)(1.96 * sqrt_newton((n - 1.0) * (Double)ieeeSumSq));
+  const ULong ifCI = (ULong)(1.96 * sqrt_newton((n - 1.0) * (Double)ifSumSq));
+
+  VG_(umsg)("Sampling 1/%lld (seed %lld), counts are estimates\n",
+	    clo_sample_rate, clo_sample_seed);
+  VG_(umsg)("-------------------------\n");
+  VG_(umsg)("IEEE FP: %llu +/- %llu (95%%)\n", ieeeFP, ieeeCI);
+  VG_(umsg)("Interflop FP: %llu +/- %llu (95%%)\n", ifFP, ifCI);
+  VG_(umsg)("-------------------------\n\n");
+}
+
+/* Prints the counters and writes the profile files           */
+/* label and dumpNo are those of a VERICHECK_DUMP, or NULL and  */
+/* -1 at the end of the execution                              */
+static void vc_report(const HChar *label, Int dumpNo)
 {
-  
-  nbVisitedFuns = ieeeFPC->size + ifFPC->size;
   ULong ieeeFP = countFP(ieeeFNC, ieeeFPC);
   ULong ifFP = countFP(ifFNC, ifFPC);
 
   ppFP("IEEE", ieeeFNC, ieeeFPC);
   VG_(umsg)("-------------------------\n");
-  VG_(umsg)("IEEE FP: %llu\n\n", ieeeFP);
+  VG_(umsg)("IEEE FP: %llu%s\n\n", ieeeFP,
+	    (clo_flop_model == FLOP_MODEL_FLOPS) ? " FLOPs" : "");
+
+  if (clo_granularity == GRANULARITY_LINE) {
+    ppLines(ieeeFNC, ieeeLNC);
+  }
+  if (clo_callgrind_out) {
+    dump_callgrind(ieeeFNC, ieeeLNC, label, dumpNo);
+  }
+  if (clo_vc_out_file) {
+    dump_profile(ieeeFP, ifFP, label, dumpNo);
+  }
+  if (clo_op_mix) {
+    ppOpMix(ieeeFNC);
+  }
+  if (clo_count_bytes) {
+    ppBytes(ieeeFNC, ieeeFPC);
+  }
 
   ppFP("Interflop", ifFNC, ifFPC);
   VG_(umsg)("-------------------------\n");
   VG_(umsg)("Interflop FP: %llu\n\n", ifFP);
 
+  if (clo_per_thread) {
+    ppThreads();
+  }
+  if (clo_context_depth > 0) {
+    Context_Print();
+  }
+  if (regionsActive) {
+    Region_Print(ieeeFP, ifFP);
+  }
+  if (clo_sample_rate > 1) {
+    ppSampling(ieeeFP, ifFP);
+  }
+
   Int ieee_ratio = -1, if_ratio = -1;
   Float den_ratio = ieeeFP + ifFP;
   
@@ -316,9 +2064,383 @@ static void vc_fini(Int exitcode)
   } else {
     VG_(umsg)("No functions visited\n");
   }
+}
+
+/* Sets all the counters to 0, the functions, lines and */
+/* contexts already seen are kept                       */
+static void vc_reset(void)
+{
+  ULong i;
+
+  reset_FPCounter(ieeeFPC);
+  reset_FPCounter(ifFPC);
+  ieeeTotal = ifTotal = 0;
+  ieeeSumSq = ifSumSq = 0;
+  if (clo_op_mix) {
+    reset_FPCounter(opMixFPC);
+  }
+  if (clo_count_bytes) {
+    reset_FPCounter(bytesFPC);
+  }
+  if (clo_granularity == GRANULARITY_LINE) {
+    for (i = 0; i < LineContainer_Size(ieeeLNC); i++) {
+      LineObj *line = LineContainer_At(ieeeLNC, i);
+      line->count = 0;
+      line->flops[0] = line->flops[1] = 0;
+    }
+  }
+  if (clo_per_thread) {
+    for (i = 0; i < VG_N_THREADS; i++) {
+      threadSlabs[i].ieee = threadSlabs[i].interflop = 0;
+    }
+  }
+  if (clo_context_depth > 0) {
+    Context_Reset();
+  }
+  Region_Reset();
+  if (clo_snapshot_interval > 0) {
+    reset_FPCounter(ieeePrevFPC);
+    reset_FPCounter(ifPrevFPC);
+  }
+}
+
+/* Discards all the translations, so that the code is */
+/* instrumented again with the new settings            */
+static void discard_all_translations(void)
+{
+  VG_(discard_translations_safely)( (Addr)0x1000, ~(SizeT)0xfff, "vericheck");
+}
+
+/* Starts or stops the collection                            */
+/* The translations made in the other state are discarded so */
+/* that the code is instrumented again, or runs without      */
+/* instrumentation                                           */
+static void set_collecting(Bool on)
+{
+  if (collecting == on) {
+    return;
+  }
+  collecting = on;
+  discard_all_translations();
+}
+
+/* Returns True if the client can store a counter at addr */
+static Bool is_client_counter(UWord addr)
+{
+  return addr != 0 &&
+    VG_(am_is_valid_for_client)((Addr)addr, sizeof(ULong), VKI_PROT_WRITE);
+}
+
+/* Copies the client string at addr into buf, of MAX_CLIENT_STRING */
+/* bytes. Returns False if the string is not readable by the client */
+/* or is not NUL-terminated within MAX_CLIENT_STRING bytes; buf is  */
+/* then "". Newlines are replaced by spaces so that the string fits */
+/* on one line of the profiles.                                     */
+#define MAX_CLIENT_STRING 256
+static Bool get_client_string(UWord addr, HChar *buf)
+{
+  Addr a = (Addr)addr;
+  UInt i;
+
+  buf[0] = '\0';
+  if (a == 0) {
+    return False;
+  }
+  for (i = 0; i < MAX_CLIENT_STRING; i++, a++) {
+    /* Each page is checked when the string reaches it */
+    if ((i == 0 || a == VG_PGROUNDDN(a)) &&
+	!VG_(am_is_valid_for_client)(VG_PGROUNDDN(a), VKI_PAGE_SIZE,
+				     VKI_PROT_READ)) {
+      break;
+    }
+    const HChar c = *(const HChar*)a;
+    buf[i] = (c == '\n' || c == '\r') ? ' ' : c;
+    if (c == '\0') {
+      return True;
+    }
+  }
+  buf[0] = '\0';
+  return False;
+}
+
+/* Handles the client requests of vericheck.h */
+static Bool vc_handle_client_request(ThreadId tid, UWord *args, UWord *ret)
+{
+  if (!VG_IS_TOOL_USERREQ('V','C',args[0])) {
+    return False;
+  }
+
+  *ret = 0;
+  switch (args[0]) {
+  case VG_USERREQ__VERICHECK_START:
+    set_collecting(True);
+    break;
+  case VG_USERREQ__VERICHECK_STOP:
+    set_collecting(False);
+    break;
+  case VG_USERREQ__VERICHECK_RESET:
+    vc_reset();
+    break;
+  case VG_USERREQ__VERICHECK_DUMP:
+    {
+      HChar label[MAX_CLIENT_STRING] = "";
+      if (args[1] && !get_client_string(args[1], label)) {
+	VG_(umsg)("Warning: VERICHECK_DUMP with an invalid label\n");
+      }
+      VG_(umsg)("Dump %d: %s\n", nbDumps, label);
+      VG_(umsg)("-------------------------\n");
+      vc_report(label, nbDumps);
+      VG_(umsg)("-------------------------\n\n");
+      nbDumps++;
+    }
+    break;
+  case VG_USERREQ__VERICHECK_REGION_BEGIN:
+    /* The code translated so far does not count per region */
+    if (!regionsActive) {
+      regionsActive = True;
+      discard_all_translations();
+    }
+    {
+      /* An invalid name still opens a region, so that the */
+      /* matching VERICHECK_REGION_END stays balanced      */
+      HChar name[MAX_CLIENT_STRING] = "";
+      if (args[1] && !get_client_string(args[1], name)) {
+	VG_(umsg)("Warning: VERICHECK_REGION_BEGIN with an invalid name\n");
+      }
+      Region_Begin(name);
+    }
+    break;
+  case VG_USERREQ__VERICHECK_REGION_END:
+    if (!Region_End()) {
+      VG_(umsg)("Warning: VERICHECK_REGION_END outside any region\n");
+    }
+    break;
+  case VG_USERREQ__VERICHECK_GET_COUNTS:
+    if (!is_client_counter(args[1]) || !is_client_counter(args[2])) {
+      break;
+    }
+    /* The request ends the superblock, so the batched */
+    /* increments before it are already done           */
+    *(ULong*)args[1] = ieeeTotal;
+    *(ULong*)args[2] = ifTotal;
+    *ret = 1;
+    break;
+  case VG_USERREQ__VERICHECK_GET_THREAD_COUNTS:
+    /* The slab of the caller is the current one */
+    if (clo_per_thread &&
+	is_client_counter(args[1]) && is_client_counter(args[2])) {
+      *(ULong*)args[1] = threadSlabs[tid].ieee;
+      *(ULong*)args[2] = threadSlabs[tid].interflop;
+      *ret = 1;
+    }
+    break;
+  default:
+    VG_(umsg)("Warning: unknown vericheck client request code %llx\n",
+	      (ULong)args[0]);
+    return False;
+  }
+  return True;
+}
+
+static void vc_fini(Int exitcode)
+{
+  
+  nbVisitedFuns = ieeeFPC->size + ifFPC->size;
+
+  /* Last snapshot, for the units elapsed since the previous one */
+  if (clo_snapshot_interval > 0) {
+    if (snapshotCountdown < clo_snapshot_interval) {
+      snapshot_take();
+    }
+    Output_Close(&snapshotOut);
+    free_FPCounter(&ieeePrevFPC);
+    free_FPCounter(&ifPrevFPC);
+  }
+
+  vc_report(NULL, -1);
 
   FnContainer_Free(&ieeeFNC);
   FnContainer_Free(&ifFNC);
+  free_FPCounter(&ieeeFPC);
+  free_FPCounter(&ifFPC);
+  if (clo_op_mix) {
+    free_FPCounter(&opMixFPC);
+  }
+  if (clo_count_bytes) {
+    free_FPCounter(&bytesFPC);
+  }
+  if (clo_granularity == GRANULARITY_LINE) {
+    LineContainer_Free(&ieeeLNC);
+  }
+  if (clo_per_thread) {
+    VG_(free)(threadSlabsBlock);
+    threadSlabs = curThreadSlab = NULL;
+  }
+  if (clo_context_depth > 0) {
+    free_Context();
+  }
+  free_Region();
+  if (clo_sample_rate > 1) {
+    SampleBlock *block;
+    VG_(OSetGen_ResetIter)(sampleBlocks);
+    while ( (block = VG_(OSetGen_Next)(sampleBlocks)) ) {
+      free_sample_batches(block);
+    }
+    VG_(OSetGen_Destroy)(sampleBlocks);
+    sampleBlocks = NULL;
+  }
+  freeDebugInfoCache();
+  free_ignored_libs();
+}
+
+static Bool vc_process_cmd_line_option(const HChar* arg)
+{
+  const HChar *pattern;
+  const HChar *rate;
+
+  if VG_BOOL_CLO(arg, "--batch-counts", clo_batch_counts) {}
+  else if VG_BOOL_CLO(arg, "--inline-counts", clo_inline_counts) {}
+  else if VG_BOOL_CLO(arg, "--op-mix", clo_op_mix) {}
+  else if VG_XACT_CLO(arg, "--flop-model=instructions",
+		      clo_flop_model, FLOP_MODEL_INSTRUCTIONS) {}
+  else if VG_XACT_CLO(arg, "--flop-model=flops",
+		      clo_flop_model, FLOP_MODEL_FLOPS) {}
+  else if VG_BOOL_CLO(arg, "--count-bytes", clo_count_bytes) {}
+  else if VG_BOOL_CLO(arg, "--per-thread", clo_per_thread) {}
+  else if VG_BINT_CLO(arg, "--context-depth", clo_context_depth,
+		      0, MAX_CONTEXT_DEPTH) {}
+  else if VG_XACT_CLO(arg, "--granularity=total",
+		      clo_granularity, GRANULARITY_TOTAL) {}
+  else if VG_XACT_CLO(arg, "--granularity=object",
+		      clo_granularity, GRANULARITY_OBJECT) {}
+  else if VG_XACT_CLO(arg, "--granularity=context",
+		      clo_granularity, GRANULARITY_CONTEXT) {}
+  else if VG_XACT_CLO(arg, "--granularity=function",
+		      clo_granularity, GRANULARITY_FUNCTION) {}
+  else if VG_XACT_CLO(arg, "--granularity=line",
+		      clo_granularity, GRANULARITY_LINE) {}
+  else if VG_BOOL_CLO(arg, "--line-addrs", clo_line_addrs) {}
+  else if VG_BOOL_CLO(arg, "--callgrind-out", clo_callgrind_out) {}
+  else if VG_STR_CLO(arg, "--callgrind-out-file", clo_callgrind_out_file) {}
+  else if VG_STR_CLO(arg, "--vc-out-file", clo_vc_out_file) {}
+  else if VG_BOOL_CLO(arg, "--collect-atstart", clo_collect_atstart) {}
+  else if VG_STR_CLO(arg, "--sample-rate", rate) {
+    /* 1/N or N */
+    HChar *end;
+    if (VG_STREQN(2, rate, "1/")) {
+      rate += 2;
+    }
+    clo_sample_rate = VG_(strtoll10)(rate, &end);
+    if (*end != '\0' || clo_sample_rate < 1) {
+      VG_(fmsg_bad_option)(arg, "expected 1/N with N >= 1\n");
+    }
+  }
+  else if VG_BINT_CLO(arg, "--sample-seed", clo_sample_seed,
+		      0, (Long)1 << 62) {}
+  else if VG_BINT_CLO(arg, "--snapshot-interval", clo_snapshot_interval,
+		      0, (Long)1 << 62) {}
+  else if VG_XACT_CLO(arg, "--snapshot-unit=instrs",
+		      clo_snapshot_unit, SNAPSHOT_UNIT_INSTRS) {}
+  else if VG_XACT_CLO(arg, "--snapshot-unit=fp",
+		      clo_snapshot_unit, SNAPSHOT_UNIT_FP) {}
+  else if VG_XACT_CLO(arg, "--snapshot-mode=delta",
+		      clo_snapshot_mode, SNAPSHOT_MODE_DELTA) {}
+  else if VG_XACT_CLO(arg, "--snapshot-mode=cumulative",
+		      clo_snapshot_mode, SNAPSHOT_MODE_CUMULATIVE) {}
+  else if VG_STR_CLO(arg, "--snapshot-file", clo_snapshot_file) {}
+  else if VG_XACT_CLO(arg, "--vc-out-format=json",
+		      clo_vc_out_format, OUT_FORMAT_JSON) {}
+  else if VG_XACT_CLO(arg, "--vc-out-format=csv",
+		      clo_vc_out_format, OUT_FORMAT_CSV) {}
+  else if VG_STR_CLO(arg, "--ignore-obj", pattern) {
+    add_scope_pattern(SCOPE_IGNORE_OBJ, pattern);
+  }
+  else if VG_STR_CLO(arg, "--ignore-fn", pattern) {
+    add_scope_pattern(SCOPE_IGNORE_FN, pattern);
+  }
+  else if VG_STR_CLO(arg, "--only-obj", pattern) {
+    add_scope_pattern(SCOPE_ONLY_OBJ, pattern);
+  }
+  else if VG_STR_CLO(arg, "--only-fn", pattern) {
+    add_scope_pattern(SCOPE_ONLY_FN, pattern);
+  }
+  else if VG_STR_CLO(arg, "--scope-file", pattern) {
+    if (!load_scope_file(pattern)) {
+      VG_(fmsg_bad_option)(arg, "cannot load the scope file\n");
+    }
+  }
+  else
+    return False;
+
+  return True;
+}
+
+static void vc_print_usage(void)
+{
+  VG_(printf)(
+"    --batch-counts=no|yes     count the FP operations of each superblock\n"
+"                              segment with a single increment [yes]\n"
+"    --inline-counts=no|yes    increment the counters with inline IR\n"
+"                              instead of helper calls [yes]\n"
+"    --op-mix=no|yes           count the IEEE FP operations of each function\n"
+"                              by precision, operation and width [no]\n"
+"    --flop-model=instructions|flops  count one per computed lane, or the\n"
+"                              FLOPs per computed lane (FMA counts 2,\n"
+"                              Neg and Abs count 0)\n"
+"                              [instructions]\n"
+"    --count-bytes=no|yes      count the bytes loaded and stored by each\n"
+"                              function and report its FP per byte [no]\n"
+"    --per-thread=no|yes       count the FP operations of each thread and\n"
+"                              report the imbalance between threads [no]\n"
+"    --context-depth=<number>  attribute the FP operations to calling\n"
+"                              contexts of <number> functions, 0 disables\n"
+"                              (max 16) [0]\n"
+"    --granularity=total|object|function|line|context  unit of attribution\n"
+"                              of the FP operations, line and context also\n"
+"                              attribute them to source lines or calling\n"
+"                              contexts [function]\n"
+"    --line-addrs=no|yes       with --granularity=line, split the lines by\n"
+"                              instruction address [no]\n"
+"    --callgrind-out=no|yes    write a callgrind-format profile, for\n"
+"                              KCachegrind or callgrind_annotate, implies\n"
+"                              --granularity=line [no]\n"
+"    --callgrind-out-file=<file>  name of the profile, %%p is replaced by\n"
+"                              the pid [vericheck.out.%%p]\n"
+"    --vc-out-file=<file>      write one record per function in <file>,\n"
+"                              %%p is replaced by the pid\n"
+"    --vc-out-format=json|csv  format of --vc-out-file [json]\n"
+"    --collect-atstart=no|yes  count from the start, otherwise wait for\n"
+"                              VERICHECK_START [yes]\n"
+"    --sample-rate=1/<number>  count one execution out of <number> of\n"
+"                              each superblock and scale the counts [1/1]\n"
+"    --sample-seed=<number>    seed of the sampling [0]\n"
+"    --snapshot-interval=<number>  write a snapshot of the counters every\n"
+"                              <number> units, 0 disables [0]\n"
+"    --snapshot-unit=instrs|fp unit of the interval, guest instructions\n"
+"                              or FP operations [fp]\n"
+"    --snapshot-mode=delta|cumulative  counts since the previous snapshot\n"
+"                              or since the start [delta]\n"
+"    --snapshot-file=<file>    name of the snapshots file, %%p is replaced\n"
+"                              by the pid [vericheck.snapshots.%%p]\n"
+"    --ignore-obj=<pattern>    do not instrument the objects (library or\n"
+"                              binary) whose path matches <pattern>\n"
+"    --ignore-fn=<pattern>     do not instrument the functions matching\n"
+"                              <pattern>\n"
+"    --only-obj=<pattern>      only instrument the objects matching\n"
+"                              <pattern>, interflop backends excepted\n"
+"    --only-fn=<pattern>       only instrument the functions matching\n"
+"                              <pattern>, interflop backends excepted\n"
+"    --scope-file=<file>       read patterns from <file>, one per line\n"
+"                              as '<ignore-obj|ignore-fn|only-obj|only-fn> <pattern>'\n"
+"    Patterns are globs ('*' and '?'), options can be repeated\n"
+  );
+}
+
+static void vc_print_debug_usage(void)
+{
+  VG_(printf)(
+"    (none)\n"
+  );
 }
 
 static void vc_pre_clo_init(void)
@@ -336,7 +2458,17 @@ static void vc_pre_clo_init(void)
                                  vc_instrument,
                                  vc_fini);
 
-   /* No needs, no core events to track */
+   VG_(needs_command_line_options)(vc_process_cmd_line_option,
+                                   vc_print_usage,
+                                   vc_print_debug_usage);
+
+   VG_(needs_client_requests)   (vc_handle_client_request);
+
+   VG_(needs_superblock_discards)(vc_discard_superblock_info);
+
+   VG_(track_new_mem_startup)   (vc_new_mem_mmap);
+   VG_(track_new_mem_mmap)      (vc_new_mem_mmap);
+   VG_(track_die_mem_munmap)    (vc_die_mem_munmap);
 }
 
 VG_DETERMINE_INTERFACE_VERSION(vc_pre_clo_init)
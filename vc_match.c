@@ -0,0 +1,461 @@
+/*--------------------------------------------------------------------*/
+/*--- Vericheck: The FP profiler Valgrind tool.         vc_match.c ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Vericheck, the FP profiler Valgrind tool,
+   which does floating-point profiling.
+
+   Copyright (C) 2020 Yohan Chatelain
+      yohan.chatelain@gmail.com
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+#include "pub_tool_basics.h"
+#include "pub_tool_libcassert.h"
+#include "pub_tool_libcbase.h"
+#include "pub_tool_mallocfree.h"
+#include "pub_tool_seqmatch.h"
+#include "pub_tool_xarray.h"
+
+#include "vc_match.h"
+
+#define INIT_SIZE_TRIE 64
+#define INIT_SIZE_HASH 64
+#define TRIE_ROOT 0
+#define NO_NODE 0xFFFFFFFF
+
+/*--------------------------------------------------------------------*/
+/*--- Tries                                                        ---*/
+/*--------------------------------------------------------------------*/
+
+/* Node of a trie                                          */
+/* - firstChild, nextSibling: Children list, for the BFS   */
+/*                            that builds the fail links   */
+/* - c       : Character of the edge from the parent       */
+/* - fail    : Aho-Corasick fail link                      */
+/* - terminal: True if a literal ends at this node         */
+/* - output  : True if a literal is a suffix of the path   */
+/*             to this node (terminal on the fail chain)   */
+typedef struct _TrieNode TrieNode;
+struct _TrieNode {
+  UInt firstChild;
+  UInt nextSibling;
+  UInt fail;
+  UChar c;
+  Bool terminal;
+  Bool output;
+};
+
+/* Transition (node, c) -> child, stored in an open-addressing */
+/* hash table so that following an edge is O(1)               */
+typedef struct _TrieEdge TrieEdge;
+struct _TrieEdge {
+  UInt from;
+  UInt to;
+  UChar c;
+};
+
+typedef struct _Trie Trie;
+struct _Trie {
+  TrieNode *nodes;
+  UInt nbNodes;
+  UInt nodesCapacity;
+  TrieEdge *edges;
+  UInt nbEdges;
+  UInt edgesCapacity;
+};
+
+static inline UInt hashEdge(UInt from, UChar c) {
+  return (from * 257 + c) * 2654435761U;
+}
+
+static void trie_init(Trie *T) {
+  T->nodesCapacity = INIT_SIZE_TRIE;
+  T->nodes = VG_(malloc)("match.trie.nodes", T->nodesCapacity * sizeof(TrieNode));
+  T->nbNodes = 1;
+  T->nodes[TRIE_ROOT].firstChild = NO_NODE;
+  T->nodes[TRIE_ROOT].nextSibling = NO_NODE;
+  T->nodes[TRIE_ROOT].fail = TRIE_ROOT;
+  T->nodes[TRIE_ROOT].c = 0;
+  T->nodes[TRIE_ROOT].terminal = False;
+  T->nodes[TRIE_ROOT].output = False;
+  T->edgesCapacity = INIT_SIZE_HASH;
+  T->edges = VG_(malloc)("match.trie.edges", T->edgesCapacity * sizeof(TrieEdge));
+  VG_(memset)(T->edges, 0xFF, T->edgesCapacity * sizeof(TrieEdge));
+  T->nbEdges = 0;
+}
+
+static void trie_free(Trie *T) {
+  VG_(free)(T->nodes);
+  VG_(free)(T->edges);
+}
+
+/* Returns the child of node for c, or NO_NODE */
+static inline UInt trie_child(const Trie *T, UInt node, UChar c) {
+  UInt i = hashEdge(node, c) & (T->edgesCapacity - 1);
+  while (T->edges[i].from != NO_NODE) {
+    if (T->edges[i].from == node && T->edges[i].c == c) {
+      return T->edges[i].to;
+    }
+    i = (i + 1) & (T->edgesCapacity - 1);
+  }
+  return NO_NODE;
+}
+
+static void trie_insertEdge(TrieEdge *edges, UInt capacity, const TrieEdge *edge) {
+  UInt i = hashEdge(edge->from, edge->c) & (capacity - 1);
+  while (edges[i].from != NO_NODE) {
+    i = (i + 1) & (capacity - 1);
+  }
+  edges[i] = *edge;
+}
+
+static UInt trie_addChild(Trie *T, UInt node, UChar c) {
+  UInt i;
+  TrieEdge edge;
+
+  if (T->nbNodes == T->nodesCapacity) {
+    T->nodesCapacity *= 2;
+    T->nodes = VG_(realloc)("match.trie.nodes", T->nodes,
+			    T->nodesCapacity * sizeof(TrieNode));
+  }
+  /* Keep the load factor of the edges under 1/2 */
+  if (2 * (T->nbEdges + 1) > T->edgesCapacity) {
+    const UInt capacity = 2 * T->edgesCapacity;
+    TrieEdge *edges = VG_(malloc)("match.trie.edges", capacity * sizeof(TrieEdge));
+    VG_(memset)(edges, 0xFF, capacity * sizeof(TrieEdge));
+    for (i = 0; i < T->edgesCapacity; i++) {
+      if (T->edges[i].from != NO_NODE) {
+	trie_insertEdge(edges, capacity, &T->edges[i]);
+      }
+    }
+    VG_(free)(T->edges);
+    T->edges = edges;
+    T->edgesCapacity = capacity;
+  }
+
+  const UInt child = T->nbNodes++;
+  T->nodes[child].firstChild = NO_NODE;
+  T->nodes[child].nextSibling = T->nodes[node].firstChild;
+  T->nodes[child].fail = TRIE_ROOT;
+  T->nodes[child].c = c;
+  T->nodes[child].terminal = False;
+  T->nodes[child].output = False;
+  T->nodes[node].firstChild = child;
+
+  edge.from = node;
+  edge.to = child;
+  edge.c = c;
+  trie_insertEdge(T->edges, T->edgesCapacity, &edge);
+  T->nbEdges++;
+  return child;
+}
+
+/* Inserts the literal lit[0..len), backward if reversed is True */
+static void trie_insert(Trie *T, const HChar *lit, SizeT len, Bool reversed) {
+  SizeT i;
+  UInt node = TRIE_ROOT;
+  for (i = 0; i < len; i++) {
+    const UChar c = (UChar)lit[(reversed) ? len - 1 - i : i];
+    UInt child = trie_child(T, node, c);
+    if (child == NO_NODE) {
+      child = trie_addChild(T, node, c);
+    }
+    node = child;
+  }
+  T->nodes[node].terminal = True;
+}
+
+/* True if a literal is a prefix of str */
+static Bool trie_matchPrefix(const Trie *T, const HChar *str) {
+  UInt node = TRIE_ROOT;
+  for (; *str; str++) {
+    if (T->nodes[node].terminal) {
+      return True;
+    }
+    node = trie_child(T, node, (UChar)*str);
+    if (node == NO_NODE) {
+      return False;
+    }
+  }
+  return T->nodes[node].terminal;
+}
+
+/* True if a literal is a suffix of str[0..len) */
+/* The trie holds the reversed literals         */
+static Bool trie_matchSuffix(const Trie *T, const HChar *str, SizeT len) {
+  UInt node = TRIE_ROOT;
+  for (; len > 0; len--) {
+    if (T->nodes[node].terminal) {
+      return True;
+    }
+    node = trie_child(T, node, (UChar)str[len - 1]);
+    if (node == NO_NODE) {
+      return False;
+    }
+  }
+  return T->nodes[node].terminal;
+}
+
+/* Builds the Aho-Corasick fail links and outputs with a BFS */
+static void trie_buildFailLinks(Trie *T) {
+  UInt head = 0, tail = 0;
+  UInt node, child, fail, next;
+  UInt *queue = VG_(malloc)("match.trie.bfs", T->nbNodes * sizeof(UInt));
+
+  T->nodes[TRIE_ROOT].output = T->nodes[TRIE_ROOT].terminal;
+  for (child = T->nodes[TRIE_ROOT].firstChild; child != NO_NODE;
+       child = T->nodes[child].nextSibling) {
+    T->nodes[child].fail = TRIE_ROOT;
+    T->nodes[child].output = T->nodes[child].terminal;
+    queue[tail++] = child;
+  }
+
+  while (head < tail) {
+    node = queue[head++];
+    for (child = T->nodes[node].firstChild; child != NO_NODE;
+	 child = T->nodes[child].nextSibling) {
+      const UChar c = T->nodes[child].c;
+      fail = T->nodes[node].fail;
+      while ((next = trie_child(T, fail, c)) == NO_NODE && fail != TRIE_ROOT) {
+	fail = T->nodes[fail].fail;
+      }
+      T->nodes[child].fail = (next == NO_NODE) ? TRIE_ROOT : next;
+      T->nodes[child].output = T->nodes[child].terminal
+	|| T->nodes[T->nodes[child].fail].output;
+      queue[tail++] = child;
+    }
+  }
+  VG_(free)(queue);
+}
+
+/* True if a literal occurs in str */
+static Bool trie_matchInfix(const Trie *T, const HChar *str) {
+  UInt node = TRIE_ROOT;
+  UInt next;
+  for (; *str; str++) {
+    const UChar c = (UChar)*str;
+    while ((next = trie_child(T, node, c)) == NO_NODE && node != TRIE_ROOT) {
+      node = T->nodes[node].fail;
+    }
+    node = (next == NO_NODE) ? TRIE_ROOT : next;
+    if (T->nodes[node].output) {
+      return True;
+    }
+  }
+  return False;
+}
+
+/*--------------------------------------------------------------------*/
+/*--- Exact names                                                  ---*/
+/*--------------------------------------------------------------------*/
+
+/* FNV-1a hash */
+static UWord hashString(const HChar *str) {
+  UWord h = 2166136261UL;
+  for (; *str; str++) {
+    h = (h ^ (UChar)*str) * 16777619UL;
+  }
+  return h;
+}
+
+static void exactSet_insert(HChar **set, UWord capacity, HChar *str) {
+  UWord i = hashString(str) & (capacity - 1);
+  while (set[i]) {
+    if (VG_(strcmp)(set[i], str) == 0) {
+      return;
+    }
+    i = (i + 1) & (capacity - 1);
+  }
+  set[i] = str;
+}
+
+/*--------------------------------------------------------------------*/
+/*--- Matcher                                                      ---*/
+/*--------------------------------------------------------------------*/
+
+/* - name     : Name of the list, for the allocator    */
+/* - patterns : Copies of all the patterns             */
+/* - exact    : Hash set of the exact names            */
+/* - matchAll : True if a pattern is made of '*' only  */
+/* - generic  : Patterns matched by VG_(string_match)  */
+/* - compiled : False if the fail links must be built  */
+struct _Matcher {
+  const HChar *name;
+  XArray *patterns;
+  HChar **exact;
+  UWord nbExact;
+  UWord exactCapacity;
+  Trie prefixes;
+  Trie suffixes;
+  Trie infixes;
+  Bool hasPrefixes;
+  Bool hasSuffixes;
+  Bool hasInfixes;
+  Bool matchAll;
+  XArray *generic;
+  Bool compiled;
+};
+
+void Matcher_Init(Matcher **M, const HChar *name) {
+  *M = VG_(malloc)("match.init", sizeof(Matcher));
+  (*M)->name = name;
+  (*M)->patterns = VG_(newXA)(VG_(malloc), "match.patterns",
+			      VG_(free), sizeof(HChar*));
+  (*M)->exactCapacity = INIT_SIZE_HASH;
+  (*M)->exact = VG_(calloc)("match.exact", (*M)->exactCapacity, sizeof(HChar*));
+  (*M)->nbExact = 0;
+  trie_init(&(*M)->prefixes);
+  trie_init(&(*M)->suffixes);
+  trie_init(&(*M)->infixes);
+  (*M)->hasPrefixes = False;
+  (*M)->hasSuffixes = False;
+  (*M)->hasInfixes = False;
+  (*M)->matchAll = False;
+  (*M)->generic = VG_(newXA)(VG_(malloc), "match.generic",
+			     VG_(free), sizeof(HChar*));
+  (*M)->compiled = True;
+}
+
+void Matcher_Free(Matcher **M) {
+  Word i;
+  for (i = 0; i < VG_(sizeXA)((*M)->patterns); i++) {
+    VG_(free)(*(HChar**)VG_(indexXA)((*M)->patterns, i));
+  }
+  VG_(deleteXA)((*M)->patterns);
+  VG_(deleteXA)((*M)->generic);
+  VG_(free)((*M)->exact);
+  trie_free(&(*M)->prefixes);
+  trie_free(&(*M)->suffixes);
+  trie_free(&(*M)->infixes);
+  VG_(free)(*M);
+  *M = NULL;
+}
+
+UInt Matcher_Size(const Matcher *M) {
+  return VG_(sizeXA)(M->patterns);
+}
+
+static void Matcher_AddExact(Matcher *M, HChar *str) {
+  UWord i;
+  if (2 * (M->nbExact + 1) > M->exactCapacity) {
+    const UWord capacity = 2 * M->exactCapacity;
+    HChar **exact = VG_(calloc)("match.exact", capacity, sizeof(HChar*));
+    for (i = 0; i < M->exactCapacity; i++) {
+      if (M->exact[i]) {
+	exactSet_insert(exact, capacity, M->exact[i]);
+      }
+    }
+    VG_(free)(M->exact);
+    M->exact = exact;
+    M->exactCapacity = capacity;
+  }
+  exactSet_insert(M->exact, M->exactCapacity, str);
+  M->nbExact++;
+}
+
+static Bool Matcher_HasExact(const Matcher *M, const HChar *str) {
+  UWord i = hashString(str) & (M->exactCapacity - 1);
+  while (M->exact[i]) {
+    if (VG_(strcmp)(M->exact[i], str) == 0) {
+      return True;
+    }
+    i = (i + 1) & (M->exactCapacity - 1);
+  }
+  return False;
+}
+
+static inline Bool isMetaChar(HChar c) {
+  return c == '*' || c == '?' || c == '\\';
+}
+
+void Matcher_Add(Matcher *M, const HChar *pattern) {
+  SizeT i;
+  HChar *copy = VG_(strdup)("match.pattern", pattern);
+  VG_(addToXA)(M->patterns, &copy);
+
+  /* Leading and trailing stars */
+  SizeT len = VG_(strlen)(copy);
+  SizeT begin = 0, end = len;
+  while (begin < len && copy[begin] == '*') {
+    begin++;
+  }
+  if (len > 0 && begin == len) {
+    M->matchAll = True;
+    return;
+  }
+  while (end > begin && copy[end - 1] == '*') {
+    end--;
+  }
+  /* The literal part must not hold any metacharacter */
+  for (i = begin; i < end; i++) {
+    if (isMetaChar(copy[i])) {
+      VG_(addToXA)(M->generic, &copy);
+      return;
+    }
+  }
+
+  const Bool leadingStar = (begin > 0);
+  const Bool trailingStar = (end < len);
+  if (!leadingStar && !trailingStar) {
+    Matcher_AddExact(M, copy);
+  } else if (!leadingStar) {
+    trie_insert(&M->prefixes, copy + begin, end - begin, False);
+    M->hasPrefixes = True;
+  } else if (!trailingStar) {
+    trie_insert(&M->suffixes, copy + begin, end - begin, True);
+    M->hasSuffixes = True;
+  } else {
+    trie_insert(&M->infixes, copy + begin, end - begin, False);
+    M->hasInfixes = True;
+    M->compiled = False;
+  }
+}
+
+Bool Matcher_Match(Matcher *M, const HChar *str) {
+  Word i;
+
+  if (M->matchAll) {
+    return True;
+  }
+  if (M->nbExact > 0 && Matcher_HasExact(M, str)) {
+    return True;
+  }
+  if (M->hasPrefixes && trie_matchPrefix(&M->prefixes, str)) {
+    return True;
+  }
+  if (M->hasSuffixes &&
+      trie_matchSuffix(&M->suffixes, str, VG_(strlen)(str))) {
+    return True;
+  }
+  if (M->hasInfixes) {
+    if (!M->compiled) {
+      trie_buildFailLinks(&M->infixes);
+      M->compiled = True;
+    }
+    if (trie_matchInfix(&M->infixes, str)) {
+      return True;
+    }
+  }
+  for (i = 0; i < VG_(sizeXA)(M->generic); i++) {
+    if (VG_(string_match)(*(HChar**)VG_(indexXA)(M->generic, i), str)) {
+      return True;
+    }
+  }
+  return False;
+}
@@ -0,0 +1,64 @@
+/*--------------------------------------------------------------------*/
+/*--- Vericheck: The FP profiler Valgrind tool.         vc_match.h ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Vericheck, the FP profiler Valgrind tool,
+   which does floating-point profiling.
+
+   Copyright (C) 2020 Yohan Chatelain
+      yohan.chatelain@gmail.com
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+#ifndef __VC_MATCH_H__
+#define __VC_MATCH_H__
+
+#include "pub_tool_basics.h"
+
+/* This module implements a compiled matcher for a list of glob      */
+/* patterns, with the semantics of VG_(string_match):                */
+/* '*' matches any sequence, '?' matches one character and '\' quotes */
+/* the next character.                                               */
+/*                                                                   */
+/* Patterns are sorted by shape when they are added:                 */
+/*   - "lit"   : exact names, stored in a hash set                   */
+/*   - "lit*"  : prefixes, stored in a trie                          */
+/*   - "*lit"  : suffixes, stored in a trie of the reversed literals */
+/*   - "*lit*" : infixes, stored in an Aho-Corasick automaton        */
+/*   - "*"     : matches everything                                  */
+/*   - others  : generic globs, matched one by one                   */
+/* Except for the generic globs, matching a string costs             */
+/* O(length of the string) whatever the number of patterns.          */
+
+typedef struct _Matcher Matcher;
+
+/* - Init: allocates an empty Matcher                             */
+/* - Free: frees a Matcher and its patterns                       */
+/* - Add: adds a pattern, the pattern is copied                   */
+/* - Match: returns True if str matches one of the patterns.      */
+/*          The automaton is (re)built if patterns were added     */
+/*          since the last match                                  */
+/* - Size: returns the number of patterns                         */
+
+void Matcher_Init(Matcher **M, const HChar *name);
+void Matcher_Free(Matcher **M);
+void Matcher_Add(Matcher *M, const HChar *pattern);
+Bool Matcher_Match(Matcher *M, const HChar *str);
+UInt Matcher_Size(const Matcher *M);
+
+#endif /* __VC_MATCH_H__ */
@@ -0,0 +1,246 @@
+/*--------------------------------------------------------------------*/
+/*--- Vericheck: The FP profiler Valgrind tool.         vc_output.c ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Vericheck, the FP profiler Valgrind tool,
+   which does floating-point profiling.
+
+   Copyright (C) 2020 Yohan Chatelain
+      yohan.chatelain@gmail.com
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+
+#include "pub_tool_basics.h"
+#include "pub_tool_libcassert.h"
+#include "pub_tool_libcbase.h"
+#include "pub_tool_libcfile.h"
+#include "pub_tool_libcprint.h"
+#include "pub_tool_mallocfree.h"
+#include "pub_tool_vki.h"
+
+#include "vc_output.h"
+
+/* Lines longer than this are formatted in a temporary buffer */
+#define OUTPUT_LINE_SIZE 4096
+#define INIT_SIZE_NAMES 1024
+
+/* Compressed name                          */
+/* - name: Address of the interned name     */
+/* - id  : ID of the name in its namespace  */
+typedef struct _OutputName OutputName;
+struct _OutputName {
+  const HChar *name;
+  UWord id;
+};
+
+/* Open-addressing table of the names of a namespace */
+typedef struct _NameTable NameTable;
+struct _NameTable {
+  OutputName *slots;
+  UWord capacity;
+  UWord size;
+};
+
+/* - fd   : File descriptor                    */
+/* - buf  : Buffer of OUTPUT_BUFFER_SIZE bytes */
+/* - used : Number of bytes in buf             */
+struct _Output {
+  Int fd;
+  HChar *buf;
+  SizeT used;
+  NameTable names[OUTPUT_NB_NS];
+};
+
+Output* Output_Open(const HChar *path) {
+  UInt i;
+  SysRes sres = VG_(open)(path, VKI_O_CREAT|VKI_O_TRUNC|VKI_O_WRONLY,
+			  VKI_S_IRUSR|VKI_S_IWUSR|VKI_S_IRGRP|VKI_S_IROTH);
+  if (sr_isError(sres)) {
+    VG_(umsg)("Error: cannot create the output file '%s'\n", path);
+    return NULL;
+  }
+
+  Output *out = VG_(malloc)("output.open", sizeof(Output));
+  out->fd = sr_Res(sres);
+  out->buf = VG_(malloc)("output.buf", OUTPUT_BUFFER_SIZE);
+  out->used = 0;
+  for (i = 0; i < OUTPUT_NB_NS; i++) {
+    out->names[i].capacity = INIT_SIZE_NAMES;
+    out->names[i].slots = VG_(calloc)("output.names", INIT_SIZE_NAMES,
+				      sizeof(OutputName));
+    out->names[i].size = 0;
+  }
+  return out;
+}
+
+static void Output_Flush(Output *out) {
+  SizeT done = 0;
+  while (done < out->used) {
+    Int n = VG_(write)(out->fd, out->buf + done, out->used - done);
+    if (n <= 0) {
+      VG_(umsg)("Error: cannot write the output file\n");
+      break;
+    }
+    done += n;
+  }
+  out->used = 0;
+}
+
+void Output_Close(Output **out) {
+  UInt i;
+  Output_Flush(*out);
+  VG_(close)((*out)->fd);
+  for (i = 0; i < OUTPUT_NB_NS; i++) {
+    VG_(free)((*out)->names[i].slots);
+  }
+  VG_(free)((*out)->buf);
+  VG_(free)(*out);
+  *out = NULL;
+}
+
+static void Output_Write(Output *out, const HChar *str, SizeT len) {
+  if (out->used + len > OUTPUT_BUFFER_SIZE) {
+    Output_Flush(out);
+  }
+  if (len > OUTPUT_BUFFER_SIZE) {
+    /* Too large for the buffer, written as is */
+    VG_(write)(out->fd, str, len);
+    return;
+  }
+  VG_(memcpy)(out->buf + out->used, str, len);
+  out->used += len;
+}
+
+void Output_Printf(Output *out, const HChar *format, ...) {
+  va_list vargs;
+  UInt n;
+  SizeT size;
+
+  if (OUTPUT_BUFFER_SIZE - out->used < OUTPUT_LINE_SIZE) {
+    Output_Flush(out);
+  }
+
+  /* VG_(vsnprintf) truncates: a full buffer means the text */
+  /* may be longer and is formatted again in a larger one   */
+  va_start(vargs, format);
+  n = VG_(vsnprintf)(out->buf + out->used, OUTPUT_BUFFER_SIZE - out->used,
+		     format, vargs);
+  va_end(vargs);
+  if (n < OUTPUT_BUFFER_SIZE - out->used - 1) {
+    out->used += n;
+    return;
+  }
+
+  for (size = 2 * OUTPUT_BUFFER_SIZE; ; size *= 2) {
+    HChar *tmp = VG_(malloc)("output.printf", size);
+    va_start(vargs, format);
+    n = VG_(vsnprintf)(tmp, size, format, vargs);
+    va_end(vargs);
+    if (n < size - 1) {
+      Output_Write(out, tmp, n);
+      VG_(free)(tmp);
+      return;
+    }
+    VG_(free)(tmp);
+  }
+}
+
+static inline UWord hashName(const HChar *name) {
+  return ((UWord)name * 11400714819323198485ULL) >> 32;
+}
+
+static void NameTable_Grow(NameTable *T) {
+  UWord i, j;
+  const UWord capacity = 2 * T->capacity;
+  OutputName *slots = VG_(calloc)("output.names", capacity, sizeof(OutputName));
+  for (i = 0; i < T->capacity; i++) {
+    if (T->slots[i].name) {
+      j = hashName(T->slots[i].name) & (capacity - 1);
+      while (slots[j].name) {
+	j = (j + 1) & (capacity - 1);
+      }
+      slots[j] = T->slots[i];
+    }
+  }
+  VG_(free)(T->slots);
+  T->slots = slots;
+  T->capacity = capacity;
+}
+
+void Output_Name(Output *out, OutputNamespace ns, const HChar *spec,
+		 const HChar *name) {
+  NameTable *T = &out->names[ns];
+  UWord i;
+
+  tl_assert(ns < OUTPUT_NB_NS);
+  if (2 * (T->size + 1) > T->capacity) {
+    NameTable_Grow(T);
+  }
+  i = hashName(name) & (T->capacity - 1);
+  while (T->slots[i].name) {
+    if (T->slots[i].name == name) {
+      Output_Printf(out, "%s=(%lu)\n", spec, T->slots[i].id);
+      return;
+    }
+    i = (i + 1) & (T->capacity - 1);
+  }
+  T->slots[i].name = name;
+  T->slots[i].id = ++T->size;
+  Output_Printf(out, "%s=(%lu) %s\n", spec, T->slots[i].id, name);
+}
+
+void Output_JSONString(Output *out, const HChar *str) {
+  HChar esc[8];
+  const HChar *start = str;
+
+  Output_Write(out, "\"", 1);
+  for (; *str; str++) {
+    const UChar c = (UChar)*str;
+    if (c != '"' && c != '\\' && c >= 0x20) {
+      continue;
+    }
+    Output_Write(out, start, str - start);
+    if (c == '"' || c == '\\') {
+      esc[0] = '\\';
+      esc[1] = c;
+      Output_Write(out, esc, 2);
+    } else {
+      VG_(sprintf)(esc, "\\u%04x", c);
+      Output_Write(out, esc, 6);
+    }
+    start = str + 1;
+  }
+  Output_Write(out, start, str - start);
+  Output_Write(out, "\"", 1);
+}
+
+void Output_CSVString(Output *out, const HChar *str) {
+  const HChar *start = str;
+
+  Output_Write(out, "\"", 1);
+  for (; *str; str++) {
+    if (*str == '"') {
+      /* Writes up to the quote included, that is written twice */
+      Output_Write(out, start, str - start + 1);
+      start = str;
+    }
+  }
+  Output_Write(out, start, str - start);
+  Output_Write(out, "\"", 1);
+}
@@ -0,0 +1,76 @@
+/*--------------------------------------------------------------------*/
+/*--- Vericheck: The FP profiler Valgrind tool.         vc_output.h ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Vericheck, the FP profiler Valgrind tool,
+   which does floating-point profiling.
+
+   Copyright (C) 2020 Yohan Chatelain
+      yohan.chatelain@gmail.com
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+
+#ifndef __VC_OUTPUT_H__
+#define __VC_OUTPUT_H__
+
+#include "pub_tool_basics.h"
+
+/* This module implements a buffered writer for the output files.   */
+/* Text is formatted in a large buffer written with a single        */
+/* VG_(write) when full, so dumping millions of lines costs a few   */
+/* system calls.                                                    */
+/*                                                                  */
+/* It also implements the name compression of the callgrind format: */
+/* the first time a name is written it is given an ID, "ob=(1) x",  */
+/* and the next times only the ID is written, "ob=(1)". Names are   */
+/* identified by their address, so they must be interned.           */
+
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+
+typedef struct _Output Output;
+
+/* Namespaces of the compressed names */
+typedef enum _OutputNamespace OutputNamespace;
+enum _OutputNamespace {
+		       OUTPUT_NS_OBJ = 0,
+		       OUTPUT_NS_FILE,
+		       OUTPUT_NS_FN,
+		       OUTPUT_NB_NS
+};
+
+/* - Open: creates or truncates the file at path, returns NULL and */
+/*         prints an error if it cannot be opened                  */
+/* - Close: flushes the buffer and closes the file                 */
+/* - Printf: formats in the buffer                                 */
+/* - Name: writes "<spec>=(<id>) <name>" or "<spec>=(<id>)" if the */
+/*         name was already written in the namespace, e.g. spec    */
+/*         "fl" and "fi" share the OUTPUT_NS_FILE namespace        */
+Output* Output_Open(const HChar *path);
+void Output_Close(Output **out);
+void Output_Printf(Output *out, const HChar *format, ...) PRINTF_CHECK(2, 3);
+void Output_Name(Output *out, OutputNamespace ns, const HChar *spec,
+		 const HChar *name);
+
+/* Quoted strings                                          */
+/* - JSON: "str" with '"', '\' and control chars escaped   */
+/* - CSV : "str" with '"' doubled                          */
+void Output_JSONString(Output *out, const HChar *str);
+void Output_CSVString(Output *out, const HChar *str);
+
+#endif /* __VC_OUTPUT_H__ */
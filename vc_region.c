@@ -0,0 +1,177 @@
+/*--------------------------------------------------------------------*/
+/*--- Vericheck: The FP profiler Valgrind tool.         vc_region.c  ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Vericheck, the FP profiler Valgrind tool,
+   which does floating-point profiling.
+
+   Copyright (C) 2020 Yohan Chatelain
+      yohan.chatelain@gmail.com
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+
+#include "pub_tool_basics.h"
+#include "pub_tool_libcassert.h"
+#include "pub_tool_libcbase.h"
+#include "pub_tool_libcprint.h"
+#include "pub_tool_mallocfree.h"
+
+#include "vc_region.h"
+
+RegionNode *curRegion = NULL;
+
+static RegionNode *rootRegion = NULL;
+
+/* Regions of the threads, indexed by ThreadId */
+static RegionNode **threadRegions = NULL;
+static ThreadId curTid = 0;
+
+static RegionNode* newRegion(const HChar *name, RegionNode *parent) {
+  RegionNode *node = VG_(calloc)("region.node", 1, sizeof(RegionNode));
+  node->name = VG_(strdup)("region.name", name);
+  node->parent = parent;
+  /* Children are kept in opening order */
+  if (parent) {
+    RegionNode **last = &parent->firstChild;
+    while (*last) {
+      last = &(*last)->nextSibling;
+    }
+    *last = node;
+  }
+  return node;
+}
+
+static void freeRegion(RegionNode *node) {
+  RegionNode *child = node->firstChild;
+  while (child) {
+    RegionNode *next = child->nextSibling;
+    freeRegion(child);
+    child = next;
+  }
+  VG_(free)(node->name);
+  VG_(free)(node);
+}
+
+void init_Region(void) {
+  ThreadId tid;
+  rootRegion = newRegion("(root)", NULL);
+  threadRegions = VG_(malloc)("region.threads", VG_N_THREADS * sizeof(RegionNode*));
+  for (tid = 0; tid < VG_N_THREADS; tid++) {
+    threadRegions[tid] = rootRegion;
+  }
+  curTid = 1;
+  curRegion = rootRegion;
+}
+
+void free_Region(void) {
+  freeRegion(rootRegion);
+  VG_(free)(threadRegions);
+  threadRegions = NULL;
+  curRegion = rootRegion = NULL;
+}
+
+void Region_SwitchThread(ThreadId tid) {
+  tl_assert(tid < VG_N_THREADS);
+  threadRegions[curTid] = curRegion;
+  curTid = tid;
+  curRegion = threadRegions[tid];
+}
+
+void Region_Begin(const HChar *name) {
+  RegionNode *child;
+  /* Regions are opened rarely, the children are searched linearly */
+  for (child = curRegion->firstChild; child; child = child->nextSibling) {
+    if (VG_(strcmp)(child->name, name) == 0) {
+      break;
+    }
+  }
+  if (child == NULL) {
+    child = newRegion(name, curRegion);
+  }
+  curRegion = child;
+}
+
+Bool Region_End(void) {
+  if (curRegion->parent == NULL) {
+    return False;
+  }
+  curRegion = curRegion->parent;
+  return True;
+}
+
+static void resetRegion(RegionNode *node) {
+  RegionNode *child;
+  node->ieee = node->interflop = 0;
+  for (child = node->firstChild; child; child = child->nextSibling) {
+    resetRegion(child);
+  }
+}
+
+void Region_Reset(void) {
+  resetRegion(rootRegion);
+}
+
+/* Computes the inclusive counts of node: its own counts */
+/* and those of its nested regions                       */
+static void inclusiveRegion(const RegionNode *node, ULong *ieee, ULong *interflop) {
+  const RegionNode *child;
+  *ieee = node->ieee;
+  *interflop = node->interflop;
+  for (child = node->firstChild; child; child = child->nextSibling) {
+    ULong childIeee, childInterflop;
+    inclusiveRegion(child, &childIeee, &childInterflop);
+    *ieee += childIeee;
+    *interflop += childInterflop;
+  }
+}
+
+/* Prints the region and its children, indented by depth */
+static void printRegion(const RegionNode *node, UInt depth,
+			ULong inclIeee, ULong inclInterflop) {
+  const RegionNode *child;
+  ULong exclIeee = inclIeee, exclInterflop = inclInterflop;
+  UInt i;
+
+  for (child = node->firstChild; child; child = child->nextSibling) {
+    ULong childIeee, childInterflop;
+    inclusiveRegion(child, &childIeee, &childInterflop);
+    exclIeee -= childIeee;
+    exclInterflop -= childInterflop;
+  }
+
+  VG_(umsg)("\t");
+  for (i = 0; i < depth; i++) {
+    VG_(umsg)("  ");
+  }
+  VG_(umsg)("* %s : %llu %llu / %llu %llu\n", node->name,
+	    inclIeee, inclInterflop, exclIeee, exclInterflop);
+
+  for (child = node->firstChild; child; child = child->nextSibling) {
+    ULong childIeee, childInterflop;
+    inclusiveRegion(child, &childIeee, &childInterflop);
+    printRegion(child, depth + 1, childIeee, childInterflop);
+  }
+}
+
+void Region_Print(ULong ieee, ULong interflop) {
+  VG_(umsg)("Regions (inclusive IEEE, Interflop / exclusive IEEE, Interflop)\n");
+  VG_(umsg)("-------------------------\n");
+  printRegion(rootRegion, 0, ieee, interflop);
+  VG_(umsg)("-------------------------\n\n");
+}
@@ -0,0 +1,87 @@
+/*--------------------------------------------------------------------*/
+/*--- Vericheck: The FP profiler Valgrind tool.         vc_region.h  ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Vericheck, the FP profiler Valgrind tool,
+   which does floating-point profiling.
+
+   Copyright (C) 2020 Yohan Chatelain
+      yohan.chatelain@gmail.com
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+
+#ifndef __VC_REGION_H__
+#define __VC_REGION_H__
+
+#include "pub_tool_basics.h"
+
+/* This module implements the measurement regions opened and      */
+/* closed by VERICHECK_REGION_BEGIN and VERICHECK_REGION_END.     */
+/*                                                                */
+/* Regions are nested: a region is identified by its name and     */
+/* its parent, so the same name opened from two regions gives two */
+/* nodes of the region tree. The root of the tree is the code     */
+/* outside any region.                                            */
+/*                                                                */
+/* Each thread is in its own region, the region of the running    */
+/* thread is in curRegion and the instrumented code adds its      */
+/* counts at (curRegion + offsetof(RegionNode, counter)).         */
+
+/* Region                                                  */
+/* - ieee, interflop: FP counters of the region itself     */
+/* - name           : Name of the region, "(root)" for the */
+/*                    root                                 */
+/* - parent         : Enclosing region, NULL for the root  */
+/* - firstChild, nextSibling: Nested regions               */
+typedef struct _RegionNode RegionNode;
+struct _RegionNode {
+  ULong ieee;
+  ULong interflop;
+  HChar *name;
+  RegionNode *parent;
+  RegionNode *firstChild;
+  RegionNode *nextSibling;
+};
+
+/* Region of the running thread */
+extern RegionNode *curRegion;
+
+/* - Init: creates the root region, all threads are in it */
+/* - Free: frees the region tree                          */
+void init_Region(void);
+void free_Region(void);
+
+/* Selects the region of the thread tid */
+void Region_SwitchThread(ThreadId tid);
+
+/* - Begin: enters the region name nested in the current one   */
+/* - End  : returns to the enclosing region, False if the      */
+/*          current region is the root                         */
+void Region_Begin(const HChar *name);
+Bool Region_End(void);
+
+/* Sets the counters of all the regions to 0 */
+void Region_Reset(void);
+
+/* Prints the inclusive and exclusive counts of the regions      */
+/* The root region is given the totals ieee and interflop of the */
+/* execution, the code run before the first region included      */
+void Region_Print(ULong ieee, ULong interflop);
+
+#endif /* __VC_REGION_H__ */
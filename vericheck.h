@@ -0,0 +1,135 @@
+/*
+   ----------------------------------------------------------------
+
+   Notice that the following BSD-style license applies to this one
+   file (vericheck.h) only.  The rest of Vericheck is licensed under
+   the terms of the GNU General Public License, version 2, unless
+   otherwise indicated.  See the COPYING file in the source
+   distribution for details.
+
+   ----------------------------------------------------------------
+
+   This file is part of Vericheck, the FP profiler Valgrind tool,
+   which does floating-point profiling.
+
+   Copyright (C) 2020 Yohan Chatelain
+      yohan.chatelain@gmail.com
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+   2. The origin of this software must not be misrepresented; you must
+      not claim that you wrote the original software.  If you use this
+      software in a product, an acknowledgment in the product
+      documentation would be appreciated but is not required.
+
+   3. Altered source versions must be plainly marked as such, and must
+      not be misrepresented as being the original software.
+
+   4. The name of the author may not be used to endorse or promote
+      products derived from this software without specific prior written
+      permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS
+   OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+   ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+   DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+   GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+   INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+   ----------------------------------------------------------------
+
+   Notice that the above BSD-style license applies to this one file
+   (vericheck.h) only.  The entire rest of Vericheck is licensed under
+   the terms of the GNU General Public License, version 2.  See the
+   COPYING file in the source distribution for details.
+
+   ----------------------------------------------------------------
+*/
+
+#ifndef __VERICHECK_H
+#define __VERICHECK_H
+
+#include "valgrind.h"
+
+/* Client requests of Vericheck                                     */
+/* The macros do nothing when the program does not run under        */
+/* Vericheck, so they can be left in production code.               */
+/*                                                                  */
+/* - VERICHECK_START      : starts counting, see --collect-atstart  */
+/* - VERICHECK_STOP       : stops counting, the code runs           */
+/*                          uninstrumented until VERICHECK_START,   */
+/*                          except for the calls and returns        */
+/*                          tracked by --context-depth              */
+/* - VERICHECK_RESET      : sets all the counters to 0              */
+/* - VERICHECK_DUMP(label): prints the counters, and writes the     */
+/*                          profile files, tagged with label        */
+/* - VERICHECK_REGION_BEGIN(name): enters the region name, nested   */
+/*                          in the current region                   */
+/* - VERICHECK_REGION_END(): returns to the enclosing region        */
+/* The counts of a region are reported inclusive and exclusive of   */
+/* its nested regions.                                              */
+/* - VERICHECK_GET_COUNTS(ieee, interflop): stores the IEEE and     */
+/*                          Interflop counts of the execution in    */
+/*                          the unsigned long long pointed to by    */
+/*                          ieee and interflop                      */
+/* - VERICHECK_GET_THREAD_COUNTS(ieee, interflop): same for the     */
+/*                          calling thread, needs --per-thread=yes  */
+/* Both return 1 if the counts were stored, 0 otherwise.            */
+
+typedef
+   enum {
+      VG_USERREQ__VERICHECK_START = VG_USERREQ_TOOL_BASE('V','C'),
+      VG_USERREQ__VERICHECK_STOP,
+      VG_USERREQ__VERICHECK_RESET,
+      VG_USERREQ__VERICHECK_DUMP,
+      VG_USERREQ__VERICHECK_REGION_BEGIN,
+      VG_USERREQ__VERICHECK_REGION_END,
+      VG_USERREQ__VERICHECK_GET_COUNTS,
+      VG_USERREQ__VERICHECK_GET_THREAD_COUNTS
+   } Vg_VericheckClientRequest;
+
+#define VERICHECK_START                                           \
+  VALGRIND_DO_CLIENT_REQUEST_STMT(VG_USERREQ__VERICHECK_START,    \
+                                  0, 0, 0, 0, 0)
+
+#define VERICHECK_STOP                                            \
+  VALGRIND_DO_CLIENT_REQUEST_STMT(VG_USERREQ__VERICHECK_STOP,     \
+                                  0, 0, 0, 0, 0)
+
+#define VERICHECK_RESET                                           \
+  VALGRIND_DO_CLIENT_REQUEST_STMT(VG_USERREQ__VERICHECK_RESET,    \
+                                  0, 0, 0, 0, 0)
+
+#define VERICHECK_DUMP(label)                                     \
+  VALGRIND_DO_CLIENT_REQUEST_STMT(VG_USERREQ__VERICHECK_DUMP,     \
+                                  label, 0, 0, 0, 0)
+
+#define VERICHECK_REGION_BEGIN(name)                              \
+  VALGRIND_DO_CLIENT_REQUEST_STMT(VG_USERREQ__VERICHECK_REGION_BEGIN, \
+                                  name, 0, 0, 0, 0)
+
+#define VERICHECK_REGION_END()                                    \
+  VALGRIND_DO_CLIENT_REQUEST_STMT(VG_USERREQ__VERICHECK_REGION_END, \
+                                  0, 0, 0, 0, 0)
+
+#define VERICHECK_GET_COUNTS(ieee, interflop)                     \
+  (unsigned)VALGRIND_DO_CLIENT_REQUEST_EXPR(0,                    \
+            VG_USERREQ__VERICHECK_GET_COUNTS,                     \
+            ieee, interflop, 0, 0, 0)
+
+#define VERICHECK_GET_THREAD_COUNTS(ieee, interflop)              \
+  (unsigned)VALGRIND_DO_CLIENT_REQUEST_EXPR(0,                    \
+            VG_USERREQ__VERICHECK_GET_THREAD_COUNTS,              \
+            ieee, interflop, 0, 0, 0)
+
+#endif /* __VERICHECK_H */